@@ -1,39 +1,251 @@
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <graphene/chain/block_log.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/thread/shared_mutex.hpp>
 
 namespace graphene { namespace chain {
     namespace detail {
-        using read_write_mutex = boost::shared_mutex;
-        using read_lock = boost::shared_lock<read_write_mutex>;
-        using write_lock = boost::unique_lock<read_write_mutex>;
+        using write_lock = std::lock_guard<std::mutex>;
         static constexpr boost::iostreams::stream_offset min_valid_file_size = sizeof(uint64_t);
 
+        static constexpr char chunked_log_magic[8] = {'V', 'I', 'Z', 'C', 'B', 'L', 'O', 'G'};
+        static constexpr uint32_t chunked_log_version = 1;
+
+        struct chunked_log_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t compression;
+            uint32_t chunk_blocks;
+            uint32_t reserved;
+        };
+
+        struct chunk_header {
+            uint32_t first_block_num;
+            uint32_t compression;
+            uint32_t block_count;
+            uint32_t raw_size;
+            uint32_t stored_size;
+            uint32_t staged_size; // size of the compressed copy after the trailer while the chunk is being sealed
+        };
+
+        static_assert(sizeof(chunked_log_header) == 24, "Unexpected padding in chunked_log_header");
+        static_assert(sizeof(chunk_header) == 24, "Unexpected padding in chunk_header");
+
+        static constexpr std::size_t min_file_grow_size = 16 * 1024 * 1024;
+        static constexpr std::size_t max_file_grow_size = 1024 * 1024 * 1024;
+
+        /**
+         * Mapping of the block log file, a reader holds it while it uses pointers into the mapping
+         */
+        struct log_file_mapping final {
+            boost::iostreams::mapped_file file;
+        };
+
+        using log_file_mapping_ptr = std::shared_ptr<const log_file_mapping>;
+
+        /**
+         * Memory mapped file, which capacity grows geometrically.
+         *
+         * The size is the logical end of data, the file itself is larger, and it's truncated to the size on close.
+         * If the file wasn't closed (e.g. crash), it has zeros after the logical end, and the size should be recovered.
+         *
+         * The writer uses data(), readers take the current mapping by acquire() and use it and size() without locking.
+         * The file is mapped again on growing, and the previous mapping is unmapped when the last reader releases it.
+         * All mappings share the same pages, so they see the same data.
+         */
+        class mapped_log_file final {
+        public:
+            ~mapped_log_file() {
+                try {
+                    close();
+                } FC_CAPTURE_AND_LOG(())
+            }
+
+            void open(const std::string& path) {
+                _path = path;
+                map(boost::filesystem::file_size(path));
+                _size.store(_capacity, std::memory_order_release);
+            }
+
+            void close() {
+                if (_data.load(std::memory_order_acquire) != nullptr) {
+                    _data.store(nullptr, std::memory_order_release);
+                    std::atomic_store(&_mapping, log_file_mapping_ptr());
+                    boost::filesystem::resize_file(_path, size());
+                }
+                _capacity = 0;
+                _size.store(0, std::memory_order_release);
+            }
+
+            bool is_open() const {
+                return data() != nullptr;
+            }
+
+            char* data() const {
+                return _data.load(std::memory_order_acquire);
+            }
+
+            /**
+             * Returns the current mapping, it covers at least size() loaded before the call
+             */
+            log_file_mapping_ptr acquire() const {
+                return std::atomic_load(&_mapping);
+            }
+
+            std::size_t size() const {
+                return _size.load(std::memory_order_acquire);
+            }
+
+            std::size_t capacity() const {
+                return _capacity;
+            }
+
+            void resize(std::size_t size) {
+                if (size > _capacity) {
+                    const auto grow_size = std::min(std::max(_capacity / 2, min_file_grow_size), max_file_grow_size);
+                    const auto new_capacity = std::max(size, _capacity + grow_size);
+                    boost::filesystem::resize_file(_path, new_capacity);
+                    map(new_capacity);
+                }
+                // the new mapping is published before the size
+                _size.store(size, std::memory_order_release);
+            }
+
+        private:
+            void map(std::size_t capacity) {
+                auto mapping = std::make_shared<log_file_mapping>();
+                mapping->file.open(_path, boost::iostreams::mapped_file::readwrite, capacity);
+                _data.store(mapping->file.data(), std::memory_order_release);
+                _capacity = capacity;
+                std::atomic_store(&_mapping, log_file_mapping_ptr(std::move(mapping)));
+            }
+
+            std::string _path;
+            log_file_mapping_ptr _mapping; // is accessed via std::atomic_load() and std::atomic_store()
+            std::atomic<char*> _data{nullptr};
+            std::atomic<std::size_t> _size{0};
+            std::size_t _capacity = 0;
+        };
+
+        /**
+         * LRU of decompressed chunks, it is shared between reader threads
+         */
+        class chunk_cache final {
+        public:
+            using data_type = std::shared_ptr<const std::vector<char>>;
+
+            void set_capacity(std::size_t value) {
+                std::lock_guard<std::mutex> lock(mutex);
+                capacity = value;
+                shrink();
+            }
+
+            data_type get(uint64_t pos) {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto itr = positions.find(pos);
+                if (itr == positions.end()) {
+                    return data_type();
+                }
+                items.splice(items.begin(), items, itr->second);
+                return itr->second->second;
+            }
+
+            void put(uint64_t pos, data_type data) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (capacity == 0 || positions.count(pos)) {
+                    return;
+                }
+                items.emplace_front(pos, std::move(data));
+                positions.emplace(pos, items.begin());
+                shrink();
+            }
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mutex);
+                positions.clear();
+                items.clear();
+            }
+
+        private:
+            void shrink() {
+                while (items.size() > capacity) {
+                    positions.erase(items.back().first);
+                    items.pop_back();
+                }
+            }
+
+            using item_list = std::list<std::pair<uint64_t, data_type>>;
+
+            std::mutex mutex;
+            std::size_t capacity = 64;
+            item_list items;
+            std::unordered_map<uint64_t, item_list::iterator> positions;
+        };
+
+        /**
+         * The writer is serialized by the mutex, readers don't lock anything.
+         *
+         * The writer appends a block, then publishes the snapshot of the head block and after it the head block number.
+         * A reader loads the head block number first, so all blocks up to it are already in files.
+         * The only exception is the head chunk of the chunked format, it's changed in place by the writer,
+         * so readers of the head chunk lock the head_chunk_mutex and get copies of its blocks.
+         */
         class block_log_impl {
         public:
-            optional<signed_block> head;
-            block_id_type head_id;
+            std::shared_ptr<const signed_block> head; // is accessed via std::atomic_load() and std::atomic_store()
+            std::atomic<uint32_t> head_num{0};
+
+            // format of a new block log
+            block_log_compression new_compression = block_log_compression::none;
+            uint32_t new_chunk_blocks = 256;
+
+            // format of the opened block log
+            bool is_chunked = false;
+            block_log_compression compression = block_log_compression::none;
+            uint32_t chunk_blocks = 0;
+            mutable chunk_cache cache;
 
             std::string block_path;
             std::string index_path;
-            boost::iostreams::mapped_file block_mapped_file;
-            boost::iostreams::mapped_file index_mapped_file;
-            read_write_mutex mutex;
+            mapped_log_file block_mapped_file;
+            mapped_log_file index_mapped_file;
+            std::mutex mutex;
+            mutable std::mutex head_chunk_mutex;
+
+            std::shared_ptr<const signed_block> get_head() const {
+                return std::atomic_load(&head);
+            }
+
+            void set_head(std::shared_ptr<const signed_block> block) {
+                const uint32_t block_num = block ? block->block_num() : 0;
+                std::atomic_store(&head, std::move(block));
+                head_num.store(block_num, std::memory_order_release);
+            }
 
             bool has_block_records() const {
                 auto size = block_mapped_file.size();
+                if (is_chunked) {
+                    return (size > sizeof(chunked_log_header));
+                }
                 return (size > min_valid_file_size);
             }
 
+            bool has_chunked_header() const {
+                return block_mapped_file.size() >= sizeof(chunked_log_header) &&
+                    std::memcmp(block_mapped_file.data(), chunked_log_magic, sizeof(chunked_log_magic)) == 0;
+            }
+
             bool has_index_records() const {
                 auto size = index_mapped_file.size();
                 return (size >= min_valid_file_size);
             }
 
-            std::size_t get_mapped_size(const boost::iostreams::mapped_file& mapped_file) const {
+            std::size_t get_mapped_size(const mapped_log_file& mapped_file) const {
                 auto size = mapped_file.size();
                 if (size < min_valid_file_size) {
                     return 0;
@@ -41,40 +253,203 @@ namespace graphene { namespace chain {
                 return size;
             }
 
-            uint64_t get_uint64(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) const {
+            uint64_t get_uint64(const mapped_log_file& mapped_file, std::size_t pos) const {
                 uint64_t value;
                 FC_ASSERT(get_mapped_size(mapped_file) >= pos + sizeof(value));
 
-                auto* ptr = mapped_file.data() + pos;
+                auto mapping = mapped_file.acquire();
+                auto* ptr = mapping->file.data() + pos;
                 value = *reinterpret_cast<uint64_t*>(ptr);
                 return value;
             }
 
-            uint64_t get_last_uint64(const boost::iostreams::mapped_file& mapped_file) const {
+            uint64_t get_last_uint64(const mapped_log_file& mapped_file) const {
                 uint64_t value;
                 auto size = get_mapped_size(mapped_file);
                 FC_ASSERT(size >= sizeof(value));
 
-                auto* ptr = mapped_file.data() + size - sizeof(value);
+                auto mapping = mapped_file.acquire();
+                auto* ptr = mapping->file.data() + size - sizeof(value);
                 value = *reinterpret_cast<uint64_t*>(ptr);
                 return value;
             }
 
             uint64_t get_block_pos(uint32_t block_num) const {
-                if (head.valid() &&
-                    block_num <= protocol::block_header::num_from_id(head_id) &&
-                    block_num > 0
-                ) {
+                if (block_num <= head_num.load(std::memory_order_acquire) && block_num > 0) {
+                    if (is_chunked) {
+                        return get_uint64(index_mapped_file, sizeof(uint64_t) * ((block_num - 1) / chunk_blocks));
+                    }
                     return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - 1));
                 }
                 return block_log::npos;
             }
 
+            chunk_header read_chunk_header(uint64_t pos) const {
+                chunk_header header;
+                FC_ASSERT(get_mapped_size(block_mapped_file) >= pos + sizeof(header));
+                auto mapping = block_mapped_file.acquire();
+                std::memcpy(&header, mapping->file.data() + pos, sizeof(header));
+                return header;
+            }
+
+            void write_chunk_header(uint64_t pos, const chunk_header& header) {
+                std::memcpy(block_mapped_file.data() + pos, &header, sizeof(header));
+            }
+
+            uint64_t get_chunk_data_pos(uint64_t pos) const {
+                return pos + sizeof(chunk_header) + sizeof(uint32_t) * chunk_blocks;
+            }
+
+            uint32_t get_chunk_offset(uint64_t pos, uint32_t idx) const {
+                uint32_t offset;
+                auto mapping = block_mapped_file.acquire();
+                std::memcpy(
+                    &offset, mapping->file.data() + pos + sizeof(chunk_header) + sizeof(offset) * idx,
+                    sizeof(offset));
+                return offset;
+            }
+
+            uint64_t get_next_chunk_pos(uint64_t pos, const chunk_header& header) const {
+                const auto end_pos = get_chunk_data_pos(pos) + header.stored_size;
+                FC_ASSERT(get_uint64(block_mapped_file, end_pos) == pos);
+                return end_pos + sizeof(uint64_t);
+            }
+
+            /**
+             * Returns the decompressed data of the chunk. The holder keeps the data: the mapping of the file
+             * or the decompressed chunk. The mapping doesn't keep the contents of the open chunk,
+             * they are valid only under the head_chunk_mutex.
+             */
+            const char* get_chunk_data(uint64_t pos, const chunk_header& header, std::shared_ptr<const void>& holder) const {
+                const auto data_pos = get_chunk_data_pos(pos);
+                FC_ASSERT(get_mapped_size(block_mapped_file) >= data_pos + header.stored_size + sizeof(uint64_t));
+
+                auto mapping = block_mapped_file.acquire();
+                const auto* ptr = mapping->file.data() + data_pos;
+                const auto chunk_compression = static_cast<block_log_compression>(header.compression);
+                if (chunk_compression == block_log_compression::none) {
+                    holder = std::move(mapping);
+                    return ptr;
+                }
+
+                auto data = cache.get(pos);
+                if (!data) {
+                    auto decompressed = std::make_shared<std::vector<char>>();
+                    decompress_block_log_chunk(chunk_compression, ptr, header.stored_size, header.raw_size, *decompressed);
+                    data = decompressed;
+                    cache.put(pos, data);
+                }
+                holder = data;
+                return data->data();
+            }
+
+            void read_chunk_raw_block(uint64_t pos, const chunk_header& header, uint32_t idx, raw_block_view& view) const {
+                FC_ASSERT(idx < header.block_count);
+                FC_ASSERT(header.block_count <= chunk_blocks);
+
+                std::shared_ptr<const void> holder;
+                const auto* data = get_chunk_data(pos, header, holder);
+
+                const auto begin = get_chunk_offset(pos, idx);
+                const auto end = (idx + 1 < header.block_count) ? get_chunk_offset(pos, idx + 1) : header.raw_size;
+                FC_ASSERT(begin < end && end <= header.raw_size);
+
+                if (header.block_count < chunk_blocks) {
+                    // the open chunk is changed in place on append and on sealing, so the block is copied
+                    auto copy = std::make_shared<std::vector<char>>(data + begin, data + end);
+                    view.data = copy->data();
+                    view.size = copy->size();
+                    view.owner = std::move(copy);
+                    return;
+                }
+
+                view.data = data + begin;
+                view.size = end - begin;
+                view.owner = std::move(holder);
+            }
+
+            void read_chunk_block(uint64_t pos, const chunk_header& header, uint32_t idx, signed_block& block) const {
+                raw_block_view view;
+                read_chunk_raw_block(pos, header, idx, view);
+
+                fc::datastream<const char*> ds(view.data, view.size);
+                fc::raw::unpack(ds, block);
+            }
+
+            bool is_head_chunk(uint32_t block_num) const {
+                // a full chunk isn't changed anymore
+                const uint32_t chunk_end = ((block_num - 1) / chunk_blocks + 1) * chunk_blocks;
+                return chunk_end > head_num.load(std::memory_order_acquire);
+            }
+
+            bool read_raw_block(uint32_t block_num, raw_block_view& view) const {
+                const auto pos = get_block_pos(block_num);
+                if (pos == block_log::npos) {
+                    return false;
+                }
+
+                if (is_chunked) {
+                    if (!is_head_chunk(block_num)) {
+                        const auto header = read_chunk_header(pos);
+                        FC_ASSERT(block_num >= header.first_block_num);
+                        read_chunk_raw_block(pos, header, block_num - header.first_block_num, view);
+                        return true;
+                    }
+
+                    std::lock_guard<std::mutex> lock(head_chunk_mutex);
+                    const auto header = read_chunk_header(pos);
+                    FC_ASSERT(block_num >= header.first_block_num);
+                    read_chunk_raw_block(pos, header, block_num - header.first_block_num, view);
+                    return true;
+                }
+
+                // the next block starts after the position of this block,
+                //   the head block can have no next block yet, so its size is calculated
+                std::size_t size;
+                const auto head_block = get_head();
+                if (block_num < head_block->block_num()) {
+                    const auto next_pos = get_uint64(index_mapped_file, sizeof(uint64_t) * block_num);
+                    FC_ASSERT(next_pos >= pos + sizeof(uint64_t));
+                    size = next_pos - pos - sizeof(uint64_t);
+                } else {
+                    size = fc::raw::pack_size(*head_block);
+                }
+                FC_ASSERT(get_mapped_size(block_mapped_file) >= pos + size + sizeof(uint64_t));
+
+                auto mapping = block_mapped_file.acquire();
+                view.data = mapping->file.data() + pos;
+                view.size = size;
+                view.owner = std::move(mapping);
+                return true;
+            }
+
+            bool read_block_by_num(uint32_t block_num, signed_block& block) const {
+                const auto pos = get_block_pos(block_num);
+                if (pos == block_log::npos) {
+                    return false;
+                }
+
+                if (is_chunked) {
+                    std::unique_lock<std::mutex> lock(head_chunk_mutex, std::defer_lock);
+                    if (is_head_chunk(block_num)) {
+                        lock.lock();
+                    }
+
+                    const auto header = read_chunk_header(pos);
+                    FC_ASSERT(block_num >= header.first_block_num);
+                    read_chunk_block(pos, header, block_num - header.first_block_num, block);
+                } else {
+                    read_block(pos, block);
+                }
+                return true;
+            }
+
             uint64_t read_block(uint64_t pos, signed_block& block) const {
                 const auto file_size = get_mapped_size(block_mapped_file);
                 FC_ASSERT(file_size > pos);
 
-                const auto* ptr = block_mapped_file.data() + pos;
+                auto mapping = block_mapped_file.acquire();
+                const auto* ptr = mapping->file.data() + pos;
                 const auto available_size = file_size - pos;
                 const auto max_block_size = std::min<std::size_t>(available_size, CHAIN_BLOCK_SIZE);
 
@@ -90,7 +465,13 @@ namespace graphene { namespace chain {
             signed_block read_head() const {
                 auto pos = get_last_uint64(block_mapped_file);
                 signed_block block;
-                read_block(pos, block);
+                if (is_chunked) {
+                    const auto header = read_chunk_header(pos);
+                    FC_ASSERT(header.block_count > 0);
+                    read_chunk_block(pos, header, header.block_count - 1, block);
+                } else {
+                    read_block(pos, block);
+                }
                 return block;
             }
 
@@ -104,12 +485,189 @@ namespace graphene { namespace chain {
 
             void open_block_mapped_file() {
                 create_nonexist_file(block_path);
-                block_mapped_file.open(block_path, boost::iostreams::mapped_file::readwrite);
+                block_mapped_file.open(block_path);
             }
 
             void open_index_mapped_file() {
                 create_nonexist_file(index_path);
-                index_mapped_file.open(index_path, boost::iostreams::mapped_file::readwrite);
+                index_mapped_file.open(index_path);
+            }
+
+            void read_chunked_log_header() {
+                chunked_log_header header;
+                std::memcpy(&header, block_mapped_file.data(), sizeof(header));
+
+                FC_ASSERT(header.version == chunked_log_version,
+                    "Unsupported version of block log ${v}", ("v", header.version));
+                FC_ASSERT(header.chunk_blocks > 0, "Wrong number of blocks in chunk of block log");
+
+                compression = static_cast<block_log_compression>(header.compression);
+                FC_ASSERT(is_block_log_compression_supported(compression),
+                    "Block log is compressed with ${c}, which isn't supported by this build", ("c", compression));
+
+                is_chunked = true;
+                chunk_blocks = header.chunk_blocks;
+            }
+
+            void write_chunked_log_header() {
+                chunked_log_header header;
+                std::memcpy(header.magic, chunked_log_magic, sizeof(header.magic));
+                header.version = chunked_log_version;
+                header.compression = static_cast<uint32_t>(new_compression);
+                header.chunk_blocks = new_chunk_blocks;
+                header.reserved = 0;
+
+                block_mapped_file.resize(sizeof(header));
+                std::memcpy(block_mapped_file.data(), &header, sizeof(header));
+
+                is_chunked = true;
+                compression = new_compression;
+                chunk_blocks = new_chunk_blocks;
+            }
+
+            /**
+             * Returns true if the last position in the block file points to the last block (or chunk),
+             * which ends exactly at the end of file. It's false if files weren't closed properly.
+             */
+            bool has_valid_end() const {
+                if (!has_block_records()) {
+                    return true;
+                }
+
+                try {
+                    const auto pos = get_last_uint64(block_mapped_file);
+                    uint64_t end_pos;
+                    if (is_chunked) {
+                        FC_ASSERT(pos >= sizeof(chunked_log_header));
+                        const auto header = read_chunk_header(pos);
+                        FC_ASSERT(header.staged_size == 0);
+                        end_pos = get_next_chunk_pos(pos, header);
+                    } else {
+                        signed_block block;
+                        end_pos = read_block(pos, block);
+                    }
+                    return end_pos == block_mapped_file.size();
+                } catch (const fc::exception&) {
+                    return false;
+                }
+            }
+
+            /**
+             * Returns the end of the block (or of the chunk) with the number at the position,
+             * or block_log::npos if the record isn't valid.
+             */
+            uint64_t recover_record(uint64_t pos, uint32_t num) {
+                try {
+                    if (!is_chunked) {
+                        signed_block block;
+                        const auto end_pos = read_block(pos, block);
+                        // zeros after the end are unpacked as a block without timestamp
+                        if (block.block_num() != num || block.timestamp == fc::time_point_sec()) {
+                            return block_log::npos;
+                        }
+                        return end_pos;
+                    }
+
+                    auto header = read_chunk_header(pos);
+                    if (header.first_block_num != num * chunk_blocks + 1 ||
+                        header.block_count == 0 ||
+                        header.block_count > chunk_blocks
+                    ) {
+                        return block_log::npos;
+                    }
+
+                    if (header.staged_size != 0) {
+                        // the crash happened while the chunk was sealed, the raw data can be partially overwritten
+                        if (header.compression != static_cast<uint32_t>(block_log_compression::none) ||
+                            header.block_count != chunk_blocks ||
+                            get_staged_chunk_pos(pos, header) + header.staged_size > block_mapped_file.size()
+                        ) {
+                            return block_log::npos;
+                        }
+                        return finish_seal(pos, header);
+                    }
+
+                    const auto end_pos = get_chunk_data_pos(pos) + header.stored_size;
+                    if (end_pos + sizeof(uint64_t) > block_mapped_file.size()) {
+                        return block_log::npos;
+                    }
+
+                    if (get_uint64(block_mapped_file, end_pos) != pos) {
+                        if (header.compression != static_cast<uint32_t>(block_log_compression::none)) {
+                            return block_log::npos;
+                        }
+                        // the head chunk wasn't updated after writing of a block, the block is dropped
+                        *reinterpret_cast<uint64_t*>(block_mapped_file.data() + end_pos) = pos;
+                    }
+                    return end_pos + sizeof(uint64_t);
+                } catch (const fc::exception&) {
+                    return block_log::npos;
+                }
+            }
+
+            /**
+             * Recovers the logical end of files, which weren't truncated on close.
+             *
+             * Positions in the index are written after blocks, so the last non-zero position points to a written
+             * block (or chunk). Records after it are checked one by one and added to the index.
+             */
+            void recover_end() {
+                wlog("Block log wasn't closed properly, recovering its end...");
+
+                // only the first block of the plain format has the zero position
+                const std::size_t min_index_count = is_chunked ? 0 : 1;
+                auto index_count = index_mapped_file.size() / sizeof(uint64_t);
+                while (index_count > min_index_count &&
+                       get_uint64(index_mapped_file, (index_count - 1) * sizeof(uint64_t)) == 0
+                ) {
+                    --index_count;
+                }
+
+                uint64_t pos = is_chunked ? sizeof(chunked_log_header) : 0;
+                uint32_t num = is_chunked ? 0 : 1;
+                if (index_count > 0) {
+                    pos = get_uint64(index_mapped_file, (index_count - 1) * sizeof(uint64_t));
+                    num = is_chunked ? index_count - 1 : index_count;
+                    --index_count; // the last indexed record is checked again
+                }
+                index_mapped_file.resize(index_count * sizeof(uint64_t));
+
+                auto end_pos = pos;
+                for (;; ++num) {
+                    const auto next_pos = recover_record(pos, num);
+                    if (next_pos == block_log::npos) {
+                        break;
+                    }
+
+                    const auto index_pos = index_mapped_file.size();
+                    index_mapped_file.resize(index_pos + sizeof(pos));
+                    *reinterpret_cast<uint64_t*>(index_mapped_file.data() + index_pos) = pos;
+
+                    pos = end_pos = next_pos;
+                }
+
+                block_mapped_file.resize(end_pos);
+                ilog("Recovered block log end at ${p}, ${n} records in index",
+                    ("p", end_pos)("n", index_mapped_file.size() / sizeof(uint64_t)));
+            }
+
+            void construct_chunk_index() {
+                const auto chunk_count = (head_num.load() + chunk_blocks - 1) / chunk_blocks;
+                index_mapped_file.resize(chunk_count * sizeof(uint64_t));
+
+                uint64_t pos = sizeof(chunked_log_header);
+                uint64_t end_pos = get_last_uint64(block_mapped_file);
+                auto* idx_ptr = index_mapped_file.data();
+
+                for (uint32_t chunk_num = 0; chunk_num < chunk_count; ++chunk_num) {
+                    FC_ASSERT(pos <= end_pos);
+                    const auto header = read_chunk_header(pos);
+                    FC_ASSERT(header.first_block_num == chunk_num * chunk_blocks + 1);
+
+                    *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
+                    pos = get_next_chunk_pos(pos, header);
+                    idx_ptr += sizeof(pos);
+                }
             }
 
             void construct_index() {
@@ -117,7 +675,13 @@ namespace graphene { namespace chain {
                 index_mapped_file.close();
                 boost::filesystem::remove_all(index_path);
                 open_index_mapped_file();
-                index_mapped_file.resize(head->block_num() * sizeof(uint64_t));
+
+                if (is_chunked) {
+                    construct_chunk_index();
+                    return;
+                }
+
+                index_mapped_file.resize(head_num.load() * sizeof(uint64_t));
 
                 uint64_t pos = 0;
                 uint64_t end_pos = get_last_uint64(block_mapped_file);
@@ -134,6 +698,8 @@ namespace graphene { namespace chain {
             void open(const fc::path& file) { try {
                 block_mapped_file.close();
                 index_mapped_file.close();
+                cache.clear();
+                is_chunked = false;
 
                 block_path = file.string();
                 index_path = boost::filesystem::path(file.string() + ".index").string();
@@ -141,6 +707,26 @@ namespace graphene { namespace chain {
                 open_block_mapped_file();
                 open_index_mapped_file();
 
+                if (has_chunked_header()) {
+                    read_chunked_log_header();
+                    if (compression != new_compression || chunk_blocks != new_chunk_blocks) {
+                        wlog(
+                            "Block log has compression ${c} with ${n} blocks per chunk, "
+                            "use convert_block_log to change the format",
+                            ("c", compression)("n", chunk_blocks));
+                    }
+                } else if (has_block_records()) {
+                    if (new_compression != block_log_compression::none) {
+                        wlog("Block log isn't compressed, use convert_block_log to compress it");
+                    }
+                } else if (new_compression != block_log_compression::none) {
+                    write_chunked_log_header();
+                }
+
+                if (!has_valid_end()) {
+                    recover_end();
+                }
+
                 /* On startup of the block log, there are several states the log file and the index file can be
                  * in relation to each other.
                  *
@@ -162,8 +748,7 @@ namespace graphene { namespace chain {
 
                 if (has_block_records()) {
                     ilog("Log is nonempty");
-                    head = read_head();
-                    head_id = head->id();
+                    set_head(std::make_shared<signed_block>(read_head()));
 
                     if (has_index_records()) {
                         ilog("Index is nonempty");
@@ -189,10 +774,19 @@ namespace graphene { namespace chain {
 
                     open_block_mapped_file();
                     open_index_mapped_file();
+
+                    if (is_chunked) {
+                        write_chunked_log_header();
+                    }
                 }
             } FC_LOG_AND_RETHROW() }
 
             uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
+                if (is_chunked) {
+                    std::lock_guard<std::mutex> lock(head_chunk_mutex);
+                    return append_chunked(b, data);
+                }
+
                 const auto index_pos = get_mapped_size(index_mapped_file);
 
                 FC_ASSERT(
@@ -213,20 +807,169 @@ namespace graphene { namespace chain {
                 ptr = index_mapped_file.data() + index_pos;
                 *reinterpret_cast<uint64_t*>(ptr) = block_pos;
 
-                head = b;
-                head_id = b.id();
+                set_head(std::make_shared<signed_block>(b));
                 return block_pos;
             } FC_LOG_AND_RETHROW() }
 
+            uint64_t append_chunked(const signed_block& b, const std::vector<char>& data) {
+                const auto block_num = b.block_num();
+                const uint32_t chunk_num = (block_num - 1) / chunk_blocks;
+                const uint32_t block_idx = (block_num - 1) % chunk_blocks;
+                const auto index_pos = get_mapped_size(index_mapped_file);
+
+                uint64_t chunk_pos;
+                chunk_header header;
+
+                if (block_idx == 0) {
+                    FC_ASSERT(
+                        index_pos == sizeof(uint64_t) * chunk_num,
+                        "Append to index file occuring at wrong position.",
+                        ("position", index_pos)
+                        ("expected", chunk_num * sizeof(uint64_t)));
+
+                    chunk_pos = block_mapped_file.size();
+                    header.first_block_num = block_num;
+                    header.compression = static_cast<uint32_t>(block_log_compression::none);
+                    header.block_count = 0;
+                    header.raw_size = 0;
+                    header.stored_size = 0;
+                    header.staged_size = 0;
+
+                    const auto data_pos = get_chunk_data_pos(chunk_pos);
+                    block_mapped_file.resize(data_pos);
+                    std::memset(block_mapped_file.data() + chunk_pos, 0, data_pos - chunk_pos);
+
+                    index_mapped_file.resize(index_pos + sizeof(chunk_pos));
+                    *reinterpret_cast<uint64_t*>(index_mapped_file.data() + index_pos) = chunk_pos;
+                } else {
+                    FC_ASSERT(
+                        index_pos == sizeof(uint64_t) * (chunk_num + 1),
+                        "Append to index file occuring at wrong position.",
+                        ("position", index_pos)
+                        ("expected", (chunk_num + 1) * sizeof(uint64_t)));
+
+                    chunk_pos = get_last_uint64(index_mapped_file);
+                    FC_ASSERT(get_last_uint64(block_mapped_file) == chunk_pos);
+
+                    header = read_chunk_header(chunk_pos);
+                    FC_ASSERT(
+                        header.compression == static_cast<uint32_t>(block_log_compression::none) &&
+                        header.block_count == block_idx,
+                        "Append to block log chunk occuring at wrong position.",
+                        ("block_count", header.block_count)
+                        ("expected", block_idx));
+                }
+
+                FC_ASSERT(
+                    uint64_t(header.raw_size) + data.size() <= std::numeric_limits<uint32_t>::max(),
+                    "Chunk of block log is too large");
+
+                // the last chunk isn't compressed until it's full, so blocks are appended in place of its trailer
+                const auto data_end = get_chunk_data_pos(chunk_pos) + header.raw_size;
+                block_mapped_file.resize(data_end + data.size() + sizeof(chunk_pos));
+                auto* ptr = block_mapped_file.data() + data_end;
+                std::memcpy(ptr, data.data(), data.size());
+                ptr += data.size();
+                *reinterpret_cast<uint64_t*>(ptr) = chunk_pos;
+
+                const uint32_t offset = header.raw_size;
+                std::memcpy(
+                    block_mapped_file.data() + chunk_pos + sizeof(chunk_header) + sizeof(offset) * block_idx,
+                    &offset, sizeof(offset));
+
+                header.block_count++;
+                header.raw_size += data.size();
+                header.stored_size = header.raw_size;
+                write_chunk_header(chunk_pos, header);
+
+                if (header.block_count == chunk_blocks) {
+                    seal_chunk(chunk_pos, header);
+                }
+
+                set_head(std::make_shared<signed_block>(b));
+                return chunk_pos;
+            }
+
+            /**
+             * Compresses the full chunk. The compressed copy is staged after the trailer of the raw chunk
+             * and is marked in the header before it's moved over the raw data, so a crash at any step leaves
+             * either the intact raw chunk or the staged copy, which recovery moves again.
+             */
+            void seal_chunk(uint64_t chunk_pos, chunk_header& header) {
+                const auto data_pos = get_chunk_data_pos(chunk_pos);
+                std::vector<char> compressed;
+
+                if (!compress_block_log_chunk(
+                        compression, block_mapped_file.data() + data_pos, header.raw_size, compressed)) {
+                    return;
+                }
+
+                const auto staged_pos = get_staged_chunk_pos(chunk_pos, header);
+                block_mapped_file.resize(staged_pos + compressed.size());
+                std::memcpy(block_mapped_file.data() + staged_pos, compressed.data(), compressed.size());
+
+                header.staged_size = compressed.size();
+                write_chunk_header(chunk_pos, header);
+
+                finish_seal(chunk_pos, header);
+            }
+
+            uint64_t get_staged_chunk_pos(uint64_t chunk_pos, const chunk_header& header) const {
+                return get_chunk_data_pos(chunk_pos) + header.raw_size + sizeof(uint64_t);
+            }
+
+            /**
+             * Moves the staged compressed copy over the raw data of the chunk, returns the end of the chunk
+             */
+            uint64_t finish_seal(uint64_t chunk_pos, chunk_header& header) {
+                const auto data_pos = get_chunk_data_pos(chunk_pos);
+                const auto staged_pos = get_staged_chunk_pos(chunk_pos, header);
+                const auto staged_end = staged_pos + header.staged_size;
+
+                // the staged copy is after the raw data, so the ranges don't overlap
+                auto* ptr = block_mapped_file.data() + data_pos;
+                std::memcpy(ptr, block_mapped_file.data() + staged_pos, header.staged_size);
+                ptr += header.staged_size;
+                *reinterpret_cast<uint64_t*>(ptr) = chunk_pos;
+
+                header.compression = static_cast<uint32_t>(compression);
+                header.stored_size = header.staged_size;
+                header.staged_size = 0;
+                write_chunk_header(chunk_pos, header);
+
+                // the released tail is zeroed, because recovery after a crash looks for zeros after the end
+                const auto end_pos = data_pos + header.stored_size + sizeof(chunk_pos);
+                std::memset(block_mapped_file.data() + end_pos, 0, staged_end - end_pos);
+                block_mapped_file.resize(end_pos);
+                return end_pos;
+            }
+
             void close() {
                 block_mapped_file.close();
                 index_mapped_file.close();
-                head.reset();
-                head_id = block_id_type();
+                cache.clear();
+                is_chunked = false;
+                set_head(nullptr);
             }
         };
     }
 
+    signed_block_header raw_block_view::header() const {
+        signed_block_header result;
+        fc::datastream<const char*> ds(data, size);
+        fc::raw::unpack(ds, result);
+        return result;
+    }
+
+    raw_block_view raw_block_view::pack(const signed_block& block) {
+        auto buffer = std::make_shared<std::vector<char>>(fc::raw::pack(block));
+        raw_block_view result;
+        result.data = buffer->data();
+        result.size = buffer->size();
+        result.owner = std::move(buffer);
+        return result;
+    }
+
     block_log::block_log()
             : my(std::make_unique<detail::block_log_impl>()) {
     }
@@ -235,6 +978,26 @@ namespace graphene { namespace chain {
         flush();
     }
 
+    void block_log::set_compression(
+        block_log_compression compression, uint32_t chunk_blocks, uint32_t cache_chunks
+    ) {
+        FC_ASSERT(is_block_log_compression_supported(compression),
+            "Block log compression ${c} isn't supported by this build", ("c", compression));
+        FC_ASSERT(chunk_blocks > 0, "Chunk of block log should contain at least one block");
+
+        detail::write_lock lock(my->mutex);
+        my->new_compression = compression;
+        my->new_chunk_blocks = chunk_blocks;
+        my->cache.set_capacity(cache_chunks);
+    }
+
+    block_log_compression block_log::compression() const {
+        if (!my->is_chunked) {
+            return block_log_compression::none;
+        }
+        return my->compression;
+    }
+
     void block_log::open(const fc::path& file) {
         detail::write_lock lock(my->mutex);
         my->open(file);
@@ -246,7 +1009,6 @@ namespace graphene { namespace chain {
     }
 
     bool block_log::is_open() const {
-        detail::read_lock lock(my->mutex);
         return my->block_mapped_file.is_open();
     }
 
@@ -261,19 +1023,16 @@ namespace graphene { namespace chain {
     }
 
     std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos) const {
-        detail::read_lock lock(my->mutex);
+        FC_ASSERT(!my->is_chunked, "Chunked block log can't be read by position, use read_block_by_num()");
         std::pair<signed_block, uint64_t> result;
         result.second = my->read_block(pos, result.first);
         return result;
     }
 
     optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const { try {
-        detail::read_lock lock(my->mutex);
         optional<signed_block> result;
-        uint64_t pos = my->get_block_pos(block_num);
-        if (pos != npos) {
-            signed_block block;
-            my->read_block(pos, block);
+        signed_block block;
+        if (my->read_block_by_num(block_num, block)) {
             FC_ASSERT(
                 block.block_num() == block_num,
                 "Wrong block was read from block log (${returned} != ${expected}).",
@@ -284,18 +1043,47 @@ namespace graphene { namespace chain {
         return result;
     } FC_LOG_AND_RETHROW() }
 
+    optional<raw_block_view> block_log::read_raw_block_by_num(uint32_t block_num) const { try {
+        optional<raw_block_view> result;
+        raw_block_view view;
+        if (my->read_raw_block(block_num, view)) {
+            result = std::move(view);
+        }
+        return result;
+    } FC_LOG_AND_RETHROW() }
+
+    std::vector<raw_block_view> block_log::read_raw_blocks(uint32_t first_block_num, uint32_t count) const { try {
+        std::vector<raw_block_view> result;
+        const auto head_num = my->head_num.load(std::memory_order_acquire);
+        if (first_block_num == 0 || first_block_num > head_num) {
+            return result;
+        }
+
+        const auto last_block_num = first_block_num + std::min(count, head_num - first_block_num + 1) - 1;
+        result.reserve(last_block_num - first_block_num + 1);
+        for (auto block_num = first_block_num; block_num <= last_block_num; ++block_num) {
+            raw_block_view view;
+            FC_ASSERT(my->read_raw_block(block_num, view));
+            result.push_back(std::move(view));
+        }
+        return result;
+    } FC_LOG_AND_RETHROW() }
+
     uint64_t block_log::get_block_pos(uint32_t block_num) const {
-        detail::read_lock lock(my->mutex);
         return my->get_block_pos(block_num);
     }
 
     signed_block block_log::read_head() const {
-        detail::read_lock lock(my->mutex);
-        return my->read_head();
+        auto head = my->get_head();
+        FC_ASSERT(head, "Block log is empty");
+        return *head;
+    }
+
+    std::shared_ptr<const signed_block> block_log::head() const {
+        return my->get_head();
     }
 
-    const optional<signed_block>& block_log::head() const {
-        detail::read_lock lock(my->mutex);
-        return my->head;
+    uint32_t block_log::head_block_num() const {
+        return my->head_num.load(std::memory_order_acquire);
     }
 } } // graphene::chain
@@ -0,0 +1,107 @@
+#include <graphene/chain/block_log_compression.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <cstring>
+
+#ifdef CHAIN_BLOCK_LOG_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef CHAIN_BLOCK_LOG_LZ4
+#include <lz4.h>
+#endif
+
+namespace graphene {
+    namespace chain {
+
+#ifdef CHAIN_BLOCK_LOG_ZSTD
+        // the default level of zstd, higher levels slow down appending of blocks
+        static constexpr int zstd_compression_level = 3;
+#endif
+
+        bool is_block_log_compression_supported(block_log_compression compression) {
+            switch (compression) {
+                case block_log_compression::none:
+                    return true;
+#ifdef CHAIN_BLOCK_LOG_ZSTD
+                case block_log_compression::zstd:
+                    return true;
+#endif
+#ifdef CHAIN_BLOCK_LOG_LZ4
+                case block_log_compression::lz4:
+                    return true;
+#endif
+                default:
+                    return false;
+            }
+        }
+
+        bool compress_block_log_chunk(
+            block_log_compression compression, const char* src, std::size_t src_size, std::vector<char>& dst
+        ) {
+            switch (compression) {
+#ifdef CHAIN_BLOCK_LOG_ZSTD
+                case block_log_compression::zstd: {
+                    dst.resize(ZSTD_compressBound(src_size));
+                    auto size = ZSTD_compress(dst.data(), dst.size(), src, src_size, zstd_compression_level);
+                    FC_ASSERT(!ZSTD_isError(size), "zstd compression failed: ${e}", ("e", ZSTD_getErrorName(size)));
+                    dst.resize(size);
+                    break;
+                }
+#endif
+#ifdef CHAIN_BLOCK_LOG_LZ4
+                case block_log_compression::lz4: {
+                    FC_ASSERT(src_size <= LZ4_MAX_INPUT_SIZE, "Chunk is too large for lz4");
+                    dst.resize(LZ4_compressBound(static_cast<int>(src_size)));
+                    auto size = LZ4_compress_default(
+                        src, dst.data(), static_cast<int>(src_size), static_cast<int>(dst.size()));
+                    FC_ASSERT(size > 0, "lz4 compression failed");
+                    dst.resize(size);
+                    break;
+                }
+#endif
+                case block_log_compression::none:
+                    return false;
+
+                default:
+                    FC_THROW("Block log compression ${c} isn't supported by this build", ("c", compression));
+            }
+            return dst.size() < src_size;
+        }
+
+        void decompress_block_log_chunk(
+            block_log_compression compression, const char* src, std::size_t src_size,
+            std::size_t raw_size, std::vector<char>& dst
+        ) {
+            dst.resize(raw_size);
+            switch (compression) {
+                case block_log_compression::none:
+                    FC_ASSERT(src_size == raw_size);
+                    std::memcpy(dst.data(), src, raw_size);
+                    break;
+
+#ifdef CHAIN_BLOCK_LOG_ZSTD
+                case block_log_compression::zstd: {
+                    auto size = ZSTD_decompress(dst.data(), dst.size(), src, src_size);
+                    FC_ASSERT(!ZSTD_isError(size), "zstd decompression failed: ${e}", ("e", ZSTD_getErrorName(size)));
+                    FC_ASSERT(size == raw_size, "Wrong size of decompressed chunk");
+                    break;
+                }
+#endif
+#ifdef CHAIN_BLOCK_LOG_LZ4
+                case block_log_compression::lz4: {
+                    auto size = LZ4_decompress_safe(
+                        src, dst.data(), static_cast<int>(src_size), static_cast<int>(dst.size()));
+                    FC_ASSERT(size >= 0, "lz4 decompression failed");
+                    FC_ASSERT(static_cast<std::size_t>(size) == raw_size, "Wrong size of decompressed chunk");
+                    break;
+                }
+#endif
+                default:
+                    FC_THROW("Block log compression ${c} isn't supported by this build", ("c", compression));
+            }
+        }
+
+    }
+} // graphene::chain
@@ -0,0 +1,118 @@
+#include <graphene/chain/block_log_decoder.hpp>
+#include <graphene/chain/database_exceptions.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        block_log_decoder::block_log_decoder(
+            const block_log& log, uint32_t from_block_num, uint32_t last_block_num,
+            uint32_t read_ahead, uint32_t decoder_threads
+        )
+            : _block_log(log),
+              _last_block_num(last_block_num),
+              _slots(std::max<uint32_t>(read_ahead, 1)),
+              _next_decode_num(from_block_num),
+              _next_consume_num(from_block_num) {
+            _threads.reserve(decoder_threads);
+            for (uint32_t i = 0; i < decoder_threads; ++i) {
+                _threads.emplace_back([this]() {
+                    decode_loop();
+                });
+            }
+        }
+
+        block_log_decoder::~block_log_decoder() {
+            stop();
+        }
+
+        void block_log_decoder::stop() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopped = true;
+            }
+            _space_cond.notify_all();
+
+            for (auto& thread: _threads) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+            _threads.clear();
+        }
+
+        void block_log_decoder::decode(uint32_t block_num, slot_type& slot) const {
+            try {
+                auto block = _block_log.read_block_by_num(block_num);
+                CHAIN_ASSERT(block.valid(), block_log_exception,
+                    "Block ${n} is absent in block log.", ("n", block_num));
+                slot.item = precomputed_block(std::move(*block));
+            } catch (...) {
+                slot.error = std::current_exception();
+            }
+        }
+
+        void block_log_decoder::decode_loop() {
+            const uint32_t depth = _slots.size();
+
+            while (true) {
+                uint32_t block_num;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _space_cond.wait(lock, [&]() {
+                        return _stopped ||
+                            _next_decode_num > _last_block_num ||
+                            _next_decode_num < _next_consume_num + depth;
+                    });
+
+                    if (_stopped || _next_decode_num > _last_block_num) {
+                        return;
+                    }
+                    block_num = _next_decode_num++;
+                }
+
+                // slot is free: its previous block was already consumed
+                auto& slot = _slots[block_num % depth];
+                decode(block_num, slot);
+
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    slot.ready = true;
+                }
+                _ready_cond.notify_all();
+            }
+        }
+
+        precomputed_block block_log_decoder::next() {
+            FC_ASSERT(_next_consume_num <= _last_block_num, "No more blocks to decode");
+
+            const uint32_t depth = _slots.size();
+            auto& slot = _slots[_next_consume_num % depth];
+            precomputed_block result;
+
+            if (_threads.empty()) {
+                decode(_next_consume_num, slot);
+            } else {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _ready_cond.wait(lock, [&]() {
+                    return slot.ready;
+                });
+            }
+
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                slot.ready = false;
+                std::swap(error, slot.error);
+                result = std::move(slot.item);
+                ++_next_consume_num;
+            }
+            _space_cond.notify_all();
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return result;
+        }
+
+    }
+} // graphene::chain
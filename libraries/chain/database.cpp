@@ -4,6 +4,7 @@
 
 #include <graphene/protocol/chain_operations.hpp>
 
+#include <graphene/chain/block_log_decoder.hpp>
 #include <graphene/chain/block_summary_object.hpp>
 #include <graphene/chain/compound.hpp>
 #include <graphene/chain/custom_operation_interpreter.hpp>
@@ -18,6 +19,7 @@
 #include <graphene/chain/shared_db_merkle.hpp>
 #include <graphene/chain/operation_notification.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/replay_checkpoint.hpp>
 #include <graphene/chain/committee_objects.hpp>
 #include <graphene/chain/invite_objects.hpp>
 #include <graphene/chain/paid_subscription_objects.hpp>
@@ -203,11 +205,28 @@ namespace graphene { namespace chain {
             clear_pending();
         }
 
+        static thread_local int64_t thread_read_lock_wait = 0;
+
+        int64_t database::read_lock_wait() {
+            return thread_read_lock_wait;
+        }
+
+        void database::add_read_lock_wait(int64_t value) {
+            thread_read_lock_wait += value;
+        }
+
         void database::open(const fc::path &data_dir, const fc::path &shared_mem_dir, uint64_t initial_supply, uint64_t shared_file_size, uint32_t chainbase_flags) {
             try {
                 auto start = fc::time_point::now();
                 wlog("Start opening database. Please wait, don't break application...");
 
+                if (chainbase_flags & chainbase::database::read_write) {
+                    // a killed replay can leave the shared memory in the middle of an update
+                    FC_ASSERT(!fc::exists(replay_dirty_path(shared_mem_dir)),
+                        "Replay was terminated while applying blocks, the state can be inconsistent "
+                        "and should be replayed from the first block");
+                }
+
                 init_schema();
                 chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size);
 
@@ -223,7 +242,11 @@ namespace graphene { namespace chain {
 
                     if (!find<dynamic_global_property_object>()) {
                         with_strong_write_lock([&]() {
-                            init_genesis(initial_supply);
+                            if (_state_snapshot_import_path.empty()) {
+                                init_genesis(initial_supply);
+                            } else {
+                                import_state_snapshot(data_dir);
+                            }
                         });
                     }
 
@@ -234,6 +257,16 @@ namespace graphene { namespace chain {
                         undo_all();
                     });
 
+                    const auto checkpoint_path = replay_checkpoint_path(shared_mem_dir);
+                    if (fc::exists(checkpoint_path)) {
+                        auto checkpoint = fc::json::from_file(checkpoint_path).as<replay_checkpoint>();
+                        FC_ASSERT(checkpoint.block_num == head_block_num() && checkpoint.block_id == head_block_id(),
+                            "State at block ${h} doesn't match the replay checkpoint at block ${n}",
+                            ("h", head_block_num())("n", checkpoint.block_num));
+                        ilog("Replay will be resumed from checkpoint at block ${n}, created at ${t}",
+                             ("n", checkpoint.block_num)("t", checkpoint.created));
+                    }
+
                     if (revision() != head_block_num()) {
                         with_strong_read_lock([&]() {
                             init_hardforks(); // Writes to local state, but reads from db
@@ -289,21 +322,57 @@ namespace graphene { namespace chain {
                         skip_validate_operations | /// no need to validate operations
                         skip_block_log;
 
+                const auto checkpoint_path = replay_checkpoint_path(shared_mem_dir);
+                const auto dirty_path = replay_dirty_path(shared_mem_dir);
+                if (from_block_num == 1 && fc::exists(checkpoint_path)) {
+                    fc::remove(checkpoint_path);
+                }
+
                 with_strong_write_lock([&]() {
                     auto cur_block_num = from_block_num;
                     auto last_block_num = _block_log.head()->block_num();
                     auto last_block_pos = _block_log.get_block_pos(last_block_num);
                     int last_reindex_percent = 0;
 
+                    auto make_checkpoint = [&]() {
+                        set_revision(head_block_num());
+                        chainbase::database::flush();
+
+                        replay_checkpoint checkpoint;
+                        checkpoint.block_num = head_block_num();
+                        checkpoint.block_id = head_block_id();
+                        checkpoint.block_time = head_block_time();
+                        checkpoint.last_block_num = last_block_num;
+                        checkpoint.created = fc::time_point::now();
+
+                        const auto tmp_path = checkpoint_path.generic_string() + ".tmp";
+                        fc::json::save_to_file(checkpoint, tmp_path);
+                        fc::rename(tmp_path, checkpoint_path);
+                        fc::remove(dirty_path);
+                    };
+
+                    // blocks are read, unpacked and hashed in the decoder threads,
+                    //   the current thread only applies them
+                    block_log_decoder decoder(
+                        _block_log, from_block_num, last_block_num,
+                        _reindex_read_ahead, _reindex_decoder_threads);
+
+                    // if the process is killed while blocks are applied, the shared memory can be left inconsistent,
+                    //   the marker makes the next open() refuse the state, so the replay starts from the first block.
+                    //   Only a replay stopped by a signal writes a checkpoint to continue from.
+                    fc::json::save_to_file(head_block_num(), dirty_path);
+
                     set_reserved_memory(1024*1024*1024); // protect from memory fragmentations ...
                     while (cur_block_num < last_block_num) {
                         if (signal_guard::get_is_interrupted()) {
+                            make_checkpoint();
+                            ilog("Replay is interrupted, checkpoint is created at block ${n}", ("n", head_block_num()));
                             return;
                         }
 
                         auto end = fc::time_point::now();
                         auto cur_block_pos = _block_log.get_block_pos(cur_block_num);
-                        auto cur_block = *_block_log.read_block_by_num(cur_block_num);
+                        auto cur_block = decoder.next();
 
                         auto reindex_percent = cur_block_pos * 100 / last_block_pos;
                         if (reindex_percent - last_reindex_percent >= 1) {
@@ -326,12 +395,17 @@ namespace graphene { namespace chain {
                         cur_block_num++;
                     }
 
-                    auto cur_block = *_block_log.read_block_by_num(cur_block_num);
+                    auto cur_block = decoder.next();
                     apply_block(cur_block, skip_flags);
                     set_reserved_memory(0);
                     set_revision(head_block_num());
+                    fc::remove(dirty_path);
                 });
 
+                if (!signal_guard::get_is_interrupted() && fc::exists(checkpoint_path)) {
+                    fc::remove(checkpoint_path);
+                }
+
                 if (signal_guard::get_is_interrupted()) {
                     sg.restore();
 
@@ -349,6 +423,129 @@ namespace graphene { namespace chain {
 
         }
 
+        void database::add_snapshot_index(std::unique_ptr<abstract_snapshot_index> index) {
+            // indexes are registered again on each opening of the database
+            auto name = index->name();
+            for (auto &item : _snapshot_indexes) {
+                if (item->name() == name) {
+                    item = std::move(index);
+                    return;
+                }
+            }
+            _snapshot_indexes.push_back(std::move(index));
+        }
+
+        void database::export_state_snapshot(const fc::path &path) {
+            try {
+                auto start = fc::time_point::now();
+                const fc::path tmp_path = path.generic_string() + ".tmp";
+
+                with_weak_read_lock([&]() {
+                    state_snapshot_header header;
+                    header.chain_id = get_chain_id();
+                    header.head_block_num = head_block_num();
+                    header.head_block_id = head_block_id();
+                    header.head_block_time = head_block_time();
+                    header.index_count = _snapshot_indexes.size();
+
+                    ilog("Exporting state snapshot at block ${n} to ${p}", ("n", header.head_block_num)("p", path));
+
+                    state_snapshot_writer out(tmp_path);
+                    out.write_header(header);
+                    for (const auto &index : _snapshot_indexes) {
+                        auto count = index->size(*this);
+                        out.begin_section(index->name(), count);
+                        index->export_objects(*this, out);
+                        out.end_section();
+                        ilog("   ${t}: ${c} objects", ("t", index->name())("c", count));
+                    }
+                    out.close();
+                });
+
+                fc::rename(tmp_path, path);
+
+                auto end = fc::time_point::now();
+                ilog("Done exporting state snapshot, elapsed time: ${t} sec",
+                     ("t", double((end - start).count()) / 1000000.0));
+            }
+            FC_CAPTURE_AND_RETHROW((path))
+        }
+
+        void database::set_state_snapshot_import(const fc::path &path) {
+            _state_snapshot_import_path = path;
+        }
+
+        void database::import_state_snapshot(const fc::path &data_dir) {
+            try {
+                auto start = fc::time_point::now();
+                const auto path = _state_snapshot_import_path;
+
+                state_snapshot_reader in(path);
+                auto header = in.read_header();
+
+                ilog("Importing state snapshot at block ${n} from ${p}", ("n", header.head_block_num)("p", path));
+
+                FC_ASSERT(header.chain_id == get_chain_id(), "State snapshot is created for another chain");
+
+                // the node continues from the head block of the snapshot, so the block log should contain it
+                {
+                    block_log log;
+                    log.open(data_dir / "block_log");
+                    CHAIN_ASSERT(log.head_block_num() >= header.head_block_num, block_log_exception,
+                        "Block log doesn't contain the head block ${n} of state snapshot",
+                        ("n", header.head_block_num)("log_head", log.head_block_num()));
+
+                    auto head_block = log.read_block_by_num(header.head_block_num);
+                    CHAIN_ASSERT(head_block.valid() && head_block->id() == header.head_block_id, block_log_exception,
+                        "Head block of state snapshot doesn't match block log", ("n", header.head_block_num));
+                    log.close();
+                }
+
+                std::vector<bool> imported(_snapshot_indexes.size(), false);
+                for (uint32_t i = 0; i < header.index_count; ++i) {
+                    std::string name;
+                    uint64_t count = 0;
+                    in.begin_section(name, count);
+
+                    auto itr = std::find_if(_snapshot_indexes.begin(), _snapshot_indexes.end(), [&](const auto &index) {
+                        return index->name() == name;
+                    });
+
+                    if (itr == _snapshot_indexes.end()) {
+                        wlog("Skipping ${t} from state snapshot, the index isn't registered", ("t", name));
+                        std::vector<char> data;
+                        for (uint64_t j = 0; j < count; ++j) {
+                            in.read_object(data);
+                        }
+                    } else {
+                        FC_ASSERT((*itr)->size(*this) == 0, "Index ${t} isn't empty", ("t", name));
+                        (*itr)->import_objects(*this, in, count);
+                        imported[itr - _snapshot_indexes.begin()] = true;
+                        ilog("   ${t}: ${c} objects", ("t", name)("c", count));
+                    }
+                    in.end_section();
+                    check_free_memory(true, 0);
+                }
+
+                for (size_t i = 0; i < _snapshot_indexes.size(); ++i) {
+                    if (!imported[i]) {
+                        wlog("State snapshot doesn't contain ${t}, the index stays empty", ("t", _snapshot_indexes[i]->name()));
+                    }
+                }
+
+                FC_ASSERT(head_block_num() == header.head_block_num && head_block_id() == header.head_block_id,
+                    "State of snapshot doesn't match its header");
+
+                set_revision(head_block_num());
+                _state_snapshot_import_path = fc::path();
+
+                auto end = fc::time_point::now();
+                ilog("Done importing state snapshot, elapsed time: ${t} sec",
+                     ("t", double((end - start).count()) / 1000000.0));
+            }
+            FC_CAPTURE_AND_RETHROW((data_dir)(_state_snapshot_import_path))
+        }
+
         void database::set_min_free_shared_memory_size(size_t value) {
             _min_free_shared_memory_size = value;
         }
@@ -361,6 +558,17 @@ namespace graphene { namespace chain {
             _block_num_check_free_memory = value;
         }
 
+        void database::set_reindex_decoding(uint32_t read_ahead, uint32_t decoder_threads) {
+            _reindex_read_ahead = read_ahead;
+            _reindex_decoder_threads = decoder_threads;
+        }
+
+        void database::set_block_log_compression(
+            block_log_compression compression, uint32_t chunk_blocks, uint32_t cache_chunks
+        ) {
+            _block_log.set_compression(compression, chunk_blocks, cache_chunks);
+        }
+
         void database::set_skip_virtual_ops() {
             _skip_virtual_ops = true;
         }
@@ -432,6 +640,8 @@ namespace graphene { namespace chain {
         void database::wipe(const fc::path &data_dir, const fc::path &shared_mem_dir, bool include_blocks) {
             close();
             chainbase::database::wipe(shared_mem_dir);
+            fc::remove_all(replay_checkpoint_path(shared_mem_dir));
+            fc::remove_all(replay_dirty_path(shared_mem_dir));
             if (include_blocks) {
                 fc::remove_all(data_dir / "block_log");
                 fc::remove_all(data_dir / "block_log.index");
@@ -451,6 +661,8 @@ namespace graphene { namespace chain {
                 _block_log.close();
 
                 _fork_db.reset();
+
+                _signature_keys_cache.clear();
             }
             FC_CAPTURE_AND_RETHROW()
         }
@@ -547,6 +759,56 @@ namespace graphene { namespace chain {
             } FC_LOG_AND_RETHROW()
         }
 
+        optional<raw_block_view> database::fetch_raw_block_by_id(const block_id_type &id) const {
+            try {
+                const auto block_num = protocol::block_header::num_from_id(id);
+                if (block_num <= _block_log.head_block_num()) {
+                    auto raw = _block_log.read_raw_block_by_num(block_num);
+                    if (raw && raw->header().id() == id) {
+                        return raw;
+                    }
+                }
+
+                optional<raw_block_view> result;
+                auto b = _fork_db.fetch_block(id);
+                if (b) {
+                    result = raw_block_view::pack(b->data);
+                }
+                return result;
+            } FC_CAPTURE_AND_RETHROW()
+        }
+
+        optional<raw_block_view> database::fetch_raw_block_by_number(uint32_t block_num) const {
+            try {
+                if (block_num <= _block_log.head_block_num()) {
+                    return _block_log.read_raw_block_by_num(block_num);
+                }
+
+                optional<raw_block_view> result;
+                auto results = _fork_db.fetch_block_by_number(block_num);
+                if (results.size() == 1) {
+                    result = raw_block_view::pack(results[0]->data);
+                }
+                return result;
+            } FC_LOG_AND_RETHROW()
+        }
+
+        std::vector<raw_block_view> database::fetch_raw_blocks(uint32_t first_block_num, uint32_t count) const {
+            try {
+                auto result = _block_log.read_raw_blocks(first_block_num, count);
+
+                uint32_t block_num = first_block_num + static_cast<uint32_t>(result.size());
+                for (; result.size() < count; ++block_num) {
+                    auto raw = fetch_raw_block_by_number(block_num);
+                    if (!raw) {
+                        break;
+                    }
+                    result.push_back(std::move(*raw));
+                }
+                return result;
+            } FC_LOG_AND_RETHROW()
+        }
+
         const signed_transaction database::get_recent_transaction(const transaction_id_type &trx_id) const {
             try {
                 auto &index = get_index<transaction_index>().indices().get<by_trx_id>();
@@ -934,18 +1196,53 @@ namespace graphene { namespace chain {
         * queues.
         */
         void database::push_transaction(const signed_transaction &trx, uint32_t skip) {
+            push_transaction(precomputed_transaction(trx), skip);
+        }
+
+        void database::push_transaction(const precomputed_transaction &trx, uint32_t skip) {
             try {
-                FC_ASSERT(fc::raw::pack_size(trx) <= (get_dynamic_global_properties().maximum_block_size - 256));
+                FC_ASSERT(trx.packed_size() <= (get_dynamic_global_properties().maximum_block_size - 256));
                 with_weak_write_lock([&]() {
                     detail::with_producing(*this, [&]() {
                         _push_transaction(trx, skip);
                     });
                 });
             }
-            FC_CAPTURE_AND_RETHROW((trx))
+            FC_CAPTURE_AND_RETHROW((trx.transaction()))
         }
 
-        void database::_push_transaction(const signed_transaction &trx, uint32_t skip) {
+        std::vector<std::exception_ptr> database::push_transactions(
+            const transaction_batch &batch, const std::function<bool()> &interrupt
+        ) {
+            std::vector<std::exception_ptr> result;
+            result.reserve(batch.size());
+
+            with_weak_write_lock([&]() {
+                for (const auto &item : batch) {
+                    if (interrupt && interrupt()) {
+                        break;
+                    }
+
+                    const auto &trx = *item.first;
+                    try {
+                        try {
+                            FC_ASSERT(trx.packed_size() <= (get_dynamic_global_properties().maximum_block_size - 256));
+                            detail::with_producing(*this, [&]() {
+                                _push_transaction(trx, item.second);
+                            });
+                        }
+                        FC_CAPTURE_AND_RETHROW((trx.transaction()))
+                        result.emplace_back();
+                    } catch (...) {
+                        result.push_back(std::current_exception());
+                    }
+                }
+            });
+
+            return result;
+        }
+
+        void database::_push_transaction(const precomputed_transaction &trx, uint32_t skip) {
             // If this is the first transaction pushed after applying a block, start a new undo session.
             // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
             if (!_pending_tx_session.valid()) {
@@ -966,7 +1263,7 @@ namespace graphene { namespace chain {
             temp_session.squash();
 
             // notify anyone listening to pending transactions
-            notify_on_pending_transaction(trx);
+            notify_on_pending_transaction(trx.transaction());
         }
 
         signed_block database::generate_block(
@@ -1025,16 +1322,15 @@ namespace graphene { namespace chain {
 
                 uint64_t postponed_tx_count = 0;
                 // pop pending state (reset to head block state)
-                for (const signed_transaction &tx : _pending_tx) {
+                for (const auto &tx : _pending_tx) {
                     // Only include transactions that have not expired yet for currently generating block,
                     // this should clear problem transactions and allow block production to continue
 
-                    if (tx.expiration < when) {
+                    if (tx.transaction().expiration < when) {
                         continue;
                     }
 
-                    uint64_t new_total_size =
-                            total_block_size + fc::raw::pack_size(tx);
+                    uint64_t new_total_size = total_block_size + tx.packed_size();
 
                     // postpone transaction if it would make block too big
                     if (new_total_size >= maximum_block_size) {
@@ -1049,8 +1345,8 @@ namespace graphene { namespace chain {
                         _apply_transaction(tx, skip);
                         temp_session.squash();
 
-                        total_block_size += fc::raw::pack_size(tx);
-                        pending_block.transactions.push_back(tx);
+                        total_block_size = new_total_size;
+                        pending_block.transactions.push_back(tx.transaction());
                     }
                     catch (const fc::exception &e) {
                         // Do nothing, transaction will not be re-applied
@@ -1189,6 +1485,11 @@ namespace graphene { namespace chain {
             CHAIN_TRY_NOTIFY(applied_block, block)
         }
 
+        const std::vector<precomputed_transaction> &database::get_applied_block_transactions() const {
+            FC_ASSERT(_applied_block_transactions != nullptr, "Block isn't being applied");
+            return *_applied_block_transactions;
+        }
+
         void database::notify_on_pending_transaction(const signed_transaction &tx) {
             CHAIN_TRY_NOTIFY(on_pending_transaction, tx)
         }
@@ -3303,6 +3604,10 @@ namespace graphene { namespace chain {
         }
 
         uint32_t database::validate_transaction(const signed_transaction &trx, uint32_t skip) {
+            return validate_transaction(precomputed_transaction::refer_to(trx), skip);
+        }
+
+        uint32_t database::validate_transaction(const precomputed_transaction &trx, uint32_t skip) {
             const uint32_t validate_transaction_steps =
                 skip_authority_check |
                 skip_transaction_signatures |
@@ -3345,18 +3650,26 @@ namespace graphene { namespace chain {
         }
 
 
+        void database::precompute_signature_keys(const signed_transaction &trx) {
+            precompute_signature_keys(precomputed_transaction::refer_to(trx));
+        }
+
+        void database::precompute_signature_keys(const precomputed_transaction &trx) {
+            _signature_keys_cache.precompute(trx);
+        }
+
         public_key_type database::get_witness_key(const account_name_type& name) {
             return get_witness(name).signing_key;
         }
 
-        void database::_validate_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::_validate_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
+            const auto &trx = ptrx.transaction();
+
             if (!(skip & skip_validate_operations)) {   /* issue #505 explains why this skip_flag is disabled */
                 trx.validate();
             }
 
             if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
-                const chain_id_type &chain_id = CHAIN_ID;
-
                 auto get_active = [&](const account_name_type& name) {
                     return authority(get<account_authority_object, by_account>(name).active);
                 };
@@ -3370,7 +3683,11 @@ namespace graphene { namespace chain {
                 };
 
                 try {
-                    trx.verify_authority(chain_id, get_active, get_master, get_regular, CHAIN_MAX_SIG_CHECK_DEPTH);
+                    try {
+                        graphene::protocol::verify_authority(
+                            trx.operations, _signature_keys_cache.get(ptrx),
+                            get_active, get_master, get_regular, CHAIN_MAX_SIG_CHECK_DEPTH);
+                    } FC_CAPTURE_AND_RETHROW((trx))
                 }
                 catch (protocol::tx_missing_active_auth &e) {
                     if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end()) {
@@ -3442,6 +3759,23 @@ namespace graphene { namespace chain {
 //////////////////// private methods ////////////////////
 
         void database::apply_block(const signed_block &next_block, uint32_t skip) {
+            std::vector<precomputed_transaction> transactions;
+            transactions.reserve(next_block.transactions.size());
+            for (const auto &trx : next_block.transactions) {
+                transactions.push_back(precomputed_transaction::refer_to(trx));
+            }
+
+            apply_block(next_block, next_block.id(), transactions, skip);
+        }
+
+        void database::apply_block(const precomputed_block &next_block, uint32_t skip) {
+            apply_block(next_block.block, next_block.block_id, next_block.transactions, skip);
+        }
+
+        void database::apply_block(
+            const signed_block &next_block, const block_id_type &next_block_id,
+            const std::vector<precomputed_transaction> &transactions, uint32_t skip
+        ) {
             try {
                 //fc::time_point begin_time = fc::time_point::now();
 
@@ -3450,8 +3784,8 @@ namespace graphene { namespace chain {
                     _checkpoints.rbegin()->second != block_id_type()) {
                     auto itr = _checkpoints.find(block_num);
                     if (itr != _checkpoints.end())
-                        FC_ASSERT(next_block.id() ==
-                                  itr->second, "Block did not match checkpoint", ("checkpoint", *itr)("block_id", next_block.id()));
+                        FC_ASSERT(next_block_id ==
+                                  itr->second, "Block did not match checkpoint", ("checkpoint", *itr)("block_id", next_block_id));
 
                     if (_checkpoints.rbegin()->first >= block_num) {
                         skip = skip_witness_signature
@@ -3468,7 +3802,7 @@ namespace graphene { namespace chain {
                     }
                 }
 
-                _apply_block(next_block, skip);
+                _apply_block(next_block, next_block_id, transactions, skip);
 
                 //fc::time_point end_time = fc::time_point::now();
                 //fc::microseconds dt = end_time - begin_time;
@@ -3498,12 +3832,16 @@ namespace graphene { namespace chain {
             } FC_CAPTURE_AND_RETHROW((next_block))
         }
 
-        void database::_apply_block(const signed_block &next_block, uint32_t skip) {
+        void database::_apply_block(
+            const signed_block &next_block, const block_id_type &next_block_id,
+            const std::vector<precomputed_transaction> &transactions, uint32_t skip
+        ) {
             try {
                 uint32_t next_block_num = next_block.block_num();
                 const auto &gprops = get_dynamic_global_properties();
                 const auto &hardfork_state = get_hardfork_property_object();
-                block_id_type next_block_id = block_id_type(next_block.id());
+
+                FC_ASSERT(transactions.size() == next_block.transactions.size());
 
                 _validate_block(next_block, skip);
 
@@ -3539,7 +3877,7 @@ namespace graphene { namespace chain {
                         ("witness", witness)("next_block.witness", next_block.witness)("hardfork_state", hardfork_state)
                 );
 
-                for (const auto &trx : next_block.transactions) {
+                for (const auto &trx : transactions) {
                     /* We do not need to push the undo state for each transaction
                      * because they either all apply and are valid or the
                      * entire block fails to apply.  We only need an "undo" state
@@ -3554,12 +3892,12 @@ namespace graphene { namespace chain {
                 _current_op_in_trx = 0;
                 _current_virtual_op = 0;
 
-                update_global_dynamic_data(next_block, skip);
+                update_global_dynamic_data(next_block, next_block_id, skip);
                 update_signing_witness(signing_witness, next_block);
 
                 update_last_irreversible_block(skip);
 
-                create_block_summary(next_block);
+                create_block_summary(next_block, next_block_id);
                 clear_expired_proposals();
                 clear_expired_transactions();
                 clear_expired_delegations();
@@ -3597,7 +3935,14 @@ namespace graphene { namespace chain {
                 create_block_post_validation(next_block_num,next_block_id,next_block.witness);
 
                 // notify observers that the block has been applied
-                notify_applied_block(next_block);
+                _applied_block_transactions = &transactions;
+                try {
+                    notify_applied_block(next_block);
+                } catch (...) {
+                    _applied_block_transactions = nullptr;
+                    throw;
+                }
+                _applied_block_transactions = nullptr;
 
                 notify_changed_objects();
             } FC_CAPTURE_LOG_AND_RETHROW((next_block.block_num()))
@@ -3649,30 +3994,31 @@ namespace graphene { namespace chain {
             }
         }
 
-        void database::apply_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::apply_transaction(const precomputed_transaction &trx, uint32_t skip) {
             _apply_transaction(trx, skip);
-            notify_on_applied_transaction(trx);
+            notify_on_applied_transaction(trx.transaction());
         }
 
-        void database::_apply_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::_apply_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
+            const auto &trx = ptrx.transaction();
             try {
-                _current_trx_id = trx.id();
+                const auto &trx_id = ptrx.id();
+                _current_trx_id = trx_id;
                 _current_virtual_op = 0;
 
                 auto &trx_idx = get_index<transaction_index>();
-                auto trx_id = trx.id();
                 // idump((trx_id)(skip&skip_transaction_dupe_check));
                 FC_ASSERT((skip & skip_transaction_dupe_check) ||
                           trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
                           "Duplicate transaction check failed", ("trx_ix", trx_id));
 
-                _validate_transaction(trx, skip);
+                _validate_transaction(ptrx, skip);
 
                 flat_set<account_name_type> required;
                 vector<authority> other;
                 trx.get_required_authorities(required, required, required, other);
 
-                auto trx_size = fc::raw::pack_size(trx);
+                auto trx_size = ptrx.packed_size();
 
                 const witness_schedule_object &consensus = get_witness_schedule_object();
 
@@ -3693,7 +4039,7 @@ namespace graphene { namespace chain {
                     create<transaction_object>([&](transaction_object &transaction) {
                         transaction.trx_id = trx_id;
                         transaction.expiration = trx.expiration;
-                        fc::raw::pack(transaction.packed_trx, trx);
+                        transaction.packed_trx.assign(ptrx.packed().begin(), ptrx.packed().end());
                     });
                 }
 
@@ -3747,16 +4093,16 @@ namespace graphene { namespace chain {
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::create_block_summary(const signed_block &next_block) {
+        void database::create_block_summary(const signed_block &next_block, const block_id_type &next_block_id) {
             try {
                 block_summary_id_type sid(next_block.block_num() & 0xffff);
                 modify(get<block_summary_object>(sid), [&](block_summary_object &p) {
-                    p.block_id = next_block.id();
+                    p.block_id = next_block_id;
                 });
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::update_global_dynamic_data(const signed_block &b, uint32_t skip) {
+        void database::update_global_dynamic_data(const signed_block &b, const block_id_type &b_id, uint32_t skip) {
             try {
                 auto block_size = fc::raw::pack_size(b);
                 const dynamic_global_property_object &_dgp =
@@ -3812,7 +4158,7 @@ namespace graphene { namespace chain {
                     }
 
                     dgp.head_block_number = b.block_num();
-                    dgp.head_block_id = b.id();
+                    dgp.head_block_id = b_id;
                     dgp.time = b.timestamp;
                     dgp.current_aslot += missed_blocks + 1;
                     dgp.average_block_size =
@@ -3905,12 +4251,7 @@ namespace graphene { namespace chain {
                                 commit(dpo.last_irreversible_block_num);
 
                                 // output to block log based on new last irreverisible block num
-                                const auto &tmp_head = _block_log.head();
-                                uint64_t log_head_num = 0;
-
-                                if (tmp_head) {
-                                    log_head_num = tmp_head->block_num();
-                                }
+                                uint64_t log_head_num = _block_log.head_block_num();
 
                                 if (log_head_num < dpo.last_irreversible_block_num) {
                                     while (log_head_num < dpo.last_irreversible_block_num) {
@@ -4000,12 +4341,7 @@ namespace graphene { namespace chain {
                                 commit(dpo.last_irreversible_block_num);
 
                                 // output to block log based on new last irreverisible block num
-                                const auto &tmp_head = _block_log.head();
-                                uint64_t log_head_num = 0;
-
-                                if (tmp_head) {
-                                    log_head_num = tmp_head->block_num();
-                                }
+                                uint64_t log_head_num = _block_log.head_block_num();
 
                                 if (log_head_num < dpo.last_irreversible_block_num) {
                                     while (log_head_num < dpo.last_irreversible_block_num) {
@@ -4182,12 +4518,7 @@ namespace graphene { namespace chain {
 
                 if (!(skip & skip_block_log)) {
                     // output to block log based on new last irreverisible block num
-                    const auto &tmp_head = _block_log.head();
-                    uint64_t log_head_num = 0;
-
-                    if (tmp_head) {
-                        log_head_num = tmp_head->block_num();
-                    }
+                    uint64_t log_head_num = _block_log.head_block_num();
 
                     if (log_head_num < dpo.last_irreversible_block_num) {
                         while (log_head_num < dpo.last_irreversible_block_num) {
@@ -4229,6 +4560,8 @@ namespace graphene { namespace chain {
                    (head_block_time() > dedupe_index.begin()->expiration)) {
                 remove(*dedupe_index.begin());
             }
+
+            _signature_keys_cache.remove_expired(head_block_time());
         }
 
         void database::clear_expired_delegations() {
@@ -520,7 +520,8 @@ FC_REFLECT((graphene::chain::account_object),
                 (vesting_withdraw_rate)(next_vesting_withdrawal)(withdrawn)(to_withdraw)(withdraw_routes)
                 (curation_rewards)
                 (posting_rewards)
-                (proxied_vsf_votes)(witnesses_voted_for)
+                (receiver_awards)(benefactor_awards)
+                (proxied_vsf_votes)(witnesses_voted_for)(witnesses_vote_weight)
                 (last_root_post)(last_post)
                 (average_bandwidth)(lifetime_bandwidth)(last_bandwidth_update)
                 (valid)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fc/filesystem.hpp>
+#include <memory>
+#include <graphene/chain/block_log_compression.hpp>
 #include <graphene/protocol/block.hpp>
 
 namespace graphene {
@@ -10,6 +12,28 @@ namespace graphene {
 
         namespace detail { class block_log_impl; }
 
+        /**
+         * Serialized block without unpacking.
+         *
+         * Data points to the mapping of the block log or to a buffer (e.g. a decompressed chunk),
+         * the owner holds it while the view exists.
+         */
+        struct raw_block_view {
+            const char* data = nullptr;
+            std::size_t size = 0;
+            std::shared_ptr<const void> owner;
+
+            /**
+             * Unpacks only the header of the block, transactions are not touched
+             */
+            signed_block_header header() const;
+
+            /**
+             * Packs the block into a buffer, which is owned by the view
+             */
+            static raw_block_view pack(const signed_block& block);
+        };
+
         /* The block log is an external append only log of the blocks. Blocks should only be written
          * to the log after they irreverisble as the log is append only. The log is a doubly linked
          * list of blocks. There is a secondary index file of only block positions that enables O(1)
@@ -33,6 +57,29 @@ namespace graphene {
          *
          * The main file is the only file that needs to persist. The index file can be reconstructed during a
          * linear scan of the main file.
+         *
+         * Both files are preallocated in large steps and truncated to their real size on close. If files weren't
+         * closed, the end of the block log is recovered on open from the last position in the index.
+         *
+         * The block log also can be stored in chunks of a fixed number of blocks, which are compressed by zstd or lz4.
+         * The main file starts with a header (magic, version, compression, blocks per chunk), and each chunk
+         * is followed by its position:
+         *
+         * +--------+---------+----------------+---------+----------------+-----+------------+-------------------+
+         * | Header | Chunk 1 | Pos of Chunk 1 | Chunk 2 | Pos of Chunk 2 | ... | Head Chunk | Pos of Head Chunk |
+         * +--------+---------+----------------+---------+----------------+-----+------------+-------------------+
+         *
+         * +--------------+---------------------------------------+-------------------------------+
+         * | Chunk header | Offsets of blocks in unpacked content | Compressed content of blocks  |
+         * +--------------+---------------------------------------+-------------------------------+
+         *
+         * The head chunk isn't compressed until it's full. The compressed copy of a full chunk is written after it
+         * and marked in the chunk header before it replaces the raw data, so recovery completes an interrupted
+         * compression. The index file contains positions of chunks,
+         * a block is read by decompressing of its chunk, recently decompressed chunks are kept in memory.
+         *
+         * Reading methods don't lock and don't wait for append(), they see blocks up to the published head.
+         * open() and close() should not be called concurrently with readers.
          */
 
         class block_log {
@@ -41,6 +88,21 @@ namespace graphene {
 
             ~block_log();
 
+            /**
+             * Sets the format of a new block log, should be called before open().
+             * An existing block log keeps its format, the convert_block_log utility changes it.
+             *
+             * @param compression none means the plain format without chunks
+             * @param chunk_blocks number of blocks in a chunk
+             * @param cache_chunks number of decompressed chunks which are kept in memory
+             */
+            void set_compression(block_log_compression compression, uint32_t chunk_blocks, uint32_t cache_chunks);
+
+            /**
+             * Compression of the opened block log
+             */
+            block_log_compression compression() const;
+
             void open(const fc::path& file);
 
             void close();
@@ -56,13 +118,28 @@ namespace graphene {
             optional <signed_block> read_block_by_num(uint32_t block_num) const;
 
             /**
-             * Return offset of block in file, or block_log::npos if it does not exist.
+             * Returns the serialized block as it's stored in the block log
+             */
+            optional <raw_block_view> read_raw_block_by_num(uint32_t block_num) const;
+
+            /**
+             * Returns serialized blocks [first_block_num, first_block_num + count), the result stops at the head block
+             */
+            std::vector<raw_block_view> read_raw_blocks(uint32_t first_block_num, uint32_t count) const;
+
+            /**
+             * Return offset of block (or of its chunk) in file, or block_log::npos if it does not exist.
              */
             uint64_t get_block_pos(uint32_t block_num) const;
 
             signed_block read_head() const;
 
-            const optional <signed_block>& head() const;
+            /**
+             * Returns the snapshot of the head block, or nullptr if the block log is empty
+             */
+            std::shared_ptr<const signed_block> head() const;
+
+            uint32_t head_block_num() const;
 
             static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
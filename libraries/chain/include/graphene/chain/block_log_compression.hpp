@@ -0,0 +1,39 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace graphene {
+    namespace chain {
+
+        /**
+         * Compression of chunks in the block log
+         */
+        enum class block_log_compression: uint32_t {
+            none = 0,
+            zstd = 1,
+            lz4 = 2,
+        };
+
+        /**
+         * Returns true if the codec was found on building of the library
+         */
+        bool is_block_log_compression_supported(block_log_compression compression);
+
+        /**
+         * Compresses data into dst. Returns false if the compressed data isn't smaller than the source,
+         * in this case the chunk should be stored as is.
+         */
+        bool compress_block_log_chunk(
+            block_log_compression compression, const char* src, std::size_t src_size, std::vector<char>& dst);
+
+        void decompress_block_log_chunk(
+            block_log_compression compression, const char* src, std::size_t src_size,
+            std::size_t raw_size, std::vector<char>& dst);
+
+    }
+} // graphene::chain
+
+FC_REFLECT_ENUM(graphene::chain::block_log_compression, (none)(zstd)(lz4))
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <graphene/chain/block_log.hpp>
+#include <graphene/chain/precomputed_block.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace graphene {
+    namespace chain {
+
+        /**
+         * Reads blocks from the block log ahead of the consumer.
+         *
+         * Worker threads read, unpack and hash the blocks [from_block_num, last_block_num],
+         * and the consumer receives them strictly in order via next(). The number of decoded blocks
+         * which are waiting for the consumer is limited by the read_ahead depth.
+         *
+         * If decoder_threads is zero, blocks are decoded in the consumer thread.
+         */
+        class block_log_decoder final {
+        public:
+            block_log_decoder(
+                const block_log& log, uint32_t from_block_num, uint32_t last_block_num,
+                uint32_t read_ahead, uint32_t decoder_threads);
+
+            ~block_log_decoder();
+
+            /**
+             * Waits for the next block in order. Rethrows an exception, if the block can't be read.
+             */
+            precomputed_block next();
+
+            void stop();
+
+        private:
+            struct slot_type {
+                precomputed_block item;
+                std::exception_ptr error;
+                bool ready = false;
+            };
+
+            void decode(uint32_t block_num, slot_type& slot) const;
+
+            void decode_loop();
+
+            const block_log& _block_log;
+            const uint32_t _last_block_num;
+
+            std::vector<slot_type> _slots;
+            std::vector<std::thread> _threads;
+
+            std::mutex _mutex;
+            std::condition_variable _ready_cond;
+            std::condition_variable _space_cond;
+
+            uint32_t _next_decode_num;
+            uint32_t _next_consume_num;
+            bool _stopped = false;
+        };
+
+    }
+} // graphene::chain
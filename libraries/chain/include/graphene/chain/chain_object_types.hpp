@@ -5,6 +5,9 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
+#include <boost/interprocess/containers/flat_map.hpp>
+#include <boost/interprocess/containers/flat_set.hpp>
+
 #include <chainbase/chainbase.hpp>
 
 #include <graphene/protocol/types.hpp>
@@ -179,6 +182,67 @@ namespace fc {
         }
     }
 
+    namespace raw {
+        template<typename Stream>
+        inline void pack(Stream &s, const graphene::chain::shared_string &str) {
+            pack(s, unsigned_int(static_cast<uint32_t>(str.size())));
+            if (str.size()) {
+                s.write(str.data(), str.size());
+            }
+        }
+
+        template<typename Stream>
+        inline void unpack(Stream &s, graphene::chain::shared_string &str, uint32_t depth = 0) {
+            std::string tmp;
+            unpack(s, tmp, depth);
+            str.assign(tmp.begin(), tmp.end());
+        }
+
+        template<typename Stream, typename K, typename V, typename... A>
+        inline void pack(Stream &s, const boost::interprocess::flat_map<K, V, A...> &value) {
+            pack(s, unsigned_int(static_cast<uint32_t>(value.size())));
+            for (const auto &item : value) {
+                pack(s, item.first);
+                pack(s, item.second);
+            }
+        }
+
+        template<typename Stream, typename K, typename V, typename... A>
+        inline void unpack(Stream &s, boost::interprocess::flat_map<K, V, A...> &value, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size, depth);
+            value.clear();
+            value.reserve(size.value);
+            for (uint32_t i = 0; i < size.value; ++i) {
+                std::pair<K, V> item;
+                unpack(s, item.first, depth);
+                unpack(s, item.second, depth);
+                value.insert(std::move(item));
+            }
+        }
+
+        template<typename Stream, typename T, typename... A>
+        inline void pack(Stream &s, const boost::interprocess::flat_set<T, A...> &value) {
+            pack(s, unsigned_int(static_cast<uint32_t>(value.size())));
+            for (const auto &item : value) {
+                pack(s, item);
+            }
+        }
+
+        template<typename Stream, typename T, typename... A>
+        inline void unpack(Stream &s, boost::interprocess::flat_set<T, A...> &value, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size, depth);
+            value.clear();
+            value.reserve(size.value);
+            for (uint32_t i = 0; i < size.value; ++i) {
+                T item;
+                unpack(s, item, depth);
+                value.insert(std::move(item));
+            }
+        }
+    }
+
     namespace raw {
         using chainbase::allocator;
 
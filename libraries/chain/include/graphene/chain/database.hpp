@@ -4,6 +4,9 @@
 #include <graphene/chain/node_property_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_log.hpp>
+#include <graphene/chain/precomputed_block.hpp>
+#include <graphene/chain/signature_keys_cache.hpp>
+#include <graphene/chain/state_snapshot.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/protocol/protocol.hpp>
 
@@ -11,6 +14,8 @@
 
 #include <fc/log/logger.hpp>
 
+#include <exception>
+#include <functional>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -40,6 +45,25 @@ namespace graphene { namespace chain {
             ~database();
 
             using chainbase::database::remove;
+            using chainbase::database::with_weak_read_lock;
+
+            /**
+             * Same as chainbase::database::with_weak_read_lock(), but it also accumulates the time of waiting
+             * for the lock by the current thread, see read_lock_wait()
+             */
+            template <typename Lambda>
+            auto with_weak_read_lock(Lambda &&callback) const -> decltype(callback()) {
+                auto start = fc::time_point::now();
+                return chainbase::database::with_weak_read_lock([&]() -> decltype(callback()) {
+                    add_read_lock_wait((fc::time_point::now() - start).count());
+                    return callback();
+                });
+            }
+
+            /**
+             * Total microseconds, which the current thread waited for the read lock in with_weak_read_lock()
+             */
+            static int64_t read_lock_wait();
 
             bool is_producing() const {
                 return _is_producing;
@@ -91,11 +115,39 @@ namespace graphene { namespace chain {
             void reindex(const fc::path &data_dir, const fc::path &shared_mem_dir, uint32_t from_block_num, uint64_t shared_file_size = (
                     1024l * 1024l * 1024l * 8l));
 
+            /**
+             * Writes objects of all registered indexes, including plugin indexes, into the state snapshot
+             */
+            void export_state_snapshot(const fc::path &path);
+
+            /**
+             * Fill an empty shared memory from the state snapshot instead of the genesis on the next @ref database::open.
+             * The block log should contain the head block of the snapshot.
+             */
+            void set_state_snapshot_import(const fc::path &path);
+
+            /**
+             * Registers the exporter of the index, it's called by add_core_index() and add_plugin_index()
+             */
+            void add_snapshot_index(std::unique_ptr<abstract_snapshot_index> index);
+
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
             void check_free_memory(bool skip_print, uint32_t current_block_num);
 
+            /**
+             * Configure the block log decoding on reindex
+             * @param read_ahead how many blocks can be decoded ahead of applying
+             * @param decoder_threads number of threads which decode blocks, zero to decode in the writer thread
+             */
+            void set_reindex_decoding(uint32_t read_ahead, uint32_t decoder_threads);
+
+            /**
+             * Configure the format of a new block log, see block_log::set_compression()
+             */
+            void set_block_log_compression(block_log_compression compression, uint32_t chunk_blocks, uint32_t cache_chunks);
+
             void set_skip_virtual_ops();
 
             /**
@@ -126,6 +178,19 @@ namespace graphene { namespace chain {
 
             optional<signed_block> fetch_block_by_number(uint32_t num) const;
 
+            /**
+             * Serialized blocks. Irreversible blocks are taken from the block log without unpacking,
+             * reversible blocks are packed from the fork database.
+             */
+            optional<raw_block_view> fetch_raw_block_by_id(const block_id_type &id) const;
+
+            optional<raw_block_view> fetch_raw_block_by_number(uint32_t num) const;
+
+            /**
+             * Returns blocks [first_block_num, first_block_num + count), the result stops at the first missing block
+             */
+            std::vector<raw_block_view> fetch_raw_blocks(uint32_t first_block_num, uint32_t count) const;
+
             const signed_transaction get_recent_transaction(const transaction_id_type &trx_id) const;
 
             std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
@@ -199,11 +264,24 @@ namespace graphene { namespace chain {
 
             void push_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            void push_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
+
+            using transaction_batch = std::vector<std::pair<const precomputed_transaction *, uint32_t>>;
+
+            /**
+             * Pushes transactions with their skip flags under one acquisition of the write lock.
+             * The exception of a failed transaction is stored at its position in the result, it doesn't stop the batch.
+             * If interrupt returns true, the rest of transactions isn't pushed,
+             * so the size of the result is the number of processed transactions.
+             */
+            std::vector<std::exception_ptr> push_transactions(
+                const transaction_batch &batch, const std::function<bool()> &interrupt = std::function<bool()>());
+
             void _maybe_warn_multiple_production(uint32_t height) const;
 
             bool _push_block(const signed_block &b, uint32_t skip);
 
-            void _push_transaction(const signed_transaction &trx, uint32_t skip);
+            void _push_transaction(const precomputed_transaction &trx, uint32_t skip);
 
             void push_proposal(const proposal_object&);
 
@@ -262,6 +340,12 @@ namespace graphene { namespace chain {
              */
             fc::signal<void(const signed_block &)> applied_block;
 
+            /**
+             *  Precomputed transactions of the block, which is being applied.
+             *  It can be called only from handlers of the applied_block signal.
+             */
+            const std::vector<precomputed_transaction> &get_applied_block_transactions() const;
+
             /**
              * This signal is emitted any time a new transaction is added to the pending
              * block state.
@@ -422,10 +506,20 @@ namespace graphene { namespace chain {
              */
             uint32_t validate_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            uint32_t validate_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
+
+            /**
+             *  Recovers public keys from signatures of the transaction, so the following authority check
+             *  will not repeat the ECDSA recovery. The method doesn't lock database and can be called from any thread.
+             */
+            void precompute_signature_keys(const signed_transaction &trx);
+
+            void precompute_signature_keys(const precomputed_transaction &trx);
+
             /** when popping a block, the transactions that were removed get cached here so they
              * can be reapplied at the proper time */
             std::deque<signed_transaction> _popped_tx;
-            vector<signed_transaction> _pending_tx;
+            vector<precomputed_transaction> _pending_tx;
 
             bool has_hardfork(uint32_t hardfork) const;
 
@@ -461,19 +555,31 @@ namespace graphene { namespace chain {
             void notify_changed_objects();
 
         private:
+            static void add_read_lock_wait(int64_t value);
+
             optional<chainbase::database::session> _pending_tx_session;
 
+            void import_state_snapshot(const fc::path &data_dir);
+
             void apply_block(const signed_block &next_block, uint32_t skip = skip_nothing);
 
-            void apply_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
+            void apply_block(const precomputed_block &next_block, uint32_t skip = skip_nothing);
+
+            void apply_block(
+                const signed_block &next_block, const block_id_type &next_block_id,
+                const std::vector<precomputed_transaction> &transactions, uint32_t skip);
+
+            void apply_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
 
             void _validate_block(const signed_block& next_block, uint32_t skip);
 
-            void _apply_block(const signed_block &next_block, uint32_t skip);
+            void _apply_block(
+                const signed_block &next_block, const block_id_type &next_block_id,
+                const std::vector<precomputed_transaction> &transactions, uint32_t skip);
 
-            void _apply_transaction(const signed_transaction &trx, uint32_t skip);
+            void _apply_transaction(const precomputed_transaction &trx, uint32_t skip);
 
-            void _validate_transaction(const signed_transaction& trx, uint32_t skip);
+            void _validate_transaction(const precomputed_transaction &trx, uint32_t skip);
 
             void apply_operation(const operation &op, bool is_virtual = false);
 
@@ -483,7 +589,7 @@ namespace graphene { namespace chain {
 
             const witness_object &validate_block_header(uint32_t skip, const signed_block &next_block) const;
 
-            void create_block_summary(const signed_block &next_block);
+            void create_block_summary(const signed_block &next_block, const block_id_type &next_block_id);
 
             void update_median_witness_props();
 
@@ -493,7 +599,7 @@ namespace graphene { namespace chain {
 
             void claim_committee_account_balance();
 
-            void update_global_dynamic_data(const signed_block &b, uint32_t skip);
+            void update_global_dynamic_data(const signed_block &b, const block_id_type &b_id, uint32_t skip);
 
             void update_signing_witness(const witness_object &signing_witness, const signed_block &new_block);
 
@@ -532,7 +638,11 @@ namespace graphene { namespace chain {
 
             fc::signal<void()> _plugin_index_signal;
 
+            std::vector<std::unique_ptr<abstract_snapshot_index>> _snapshot_indexes;
+            fc::path _state_snapshot_import_path;
+
             transaction_id_type _current_trx_id;
+            const std::vector<precomputed_transaction> *_applied_block_transactions = nullptr;
             uint32_t _current_block_num = 0;
             uint16_t _current_trx_in_block = 0;
             uint16_t _current_op_in_trx = 0;
@@ -540,6 +650,8 @@ namespace graphene { namespace chain {
 
             flat_map<uint32_t, block_id_type> _checkpoints;
 
+            signature_keys_cache _signature_keys_cache;
+
             uint32_t _flush_blocks = 0;
             uint32_t _next_flush_block = 0;
 
@@ -550,6 +662,9 @@ namespace graphene { namespace chain {
 
             uint32_t _block_num_check_free_memory = 1000;
 
+            uint32_t _reindex_read_ahead = 1024;
+            uint32_t _reindex_decoder_threads = 2;
+
             bool _skip_virtual_ops = false;
             bool _enable_plugins_on_push_transaction = false;
 
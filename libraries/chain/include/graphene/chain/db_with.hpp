@@ -25,7 +25,7 @@ namespace graphene {
             struct pending_transactions_restorer final {
                 pending_transactions_restorer(
                     database &db, uint32_t skip,
-                    std::vector<signed_transaction> &&pending_transactions
+                    std::vector<precomputed_transaction> &&pending_transactions
                 )
                     : _db(db),
                       _skip(skip),
@@ -39,9 +39,11 @@ namespace graphene {
                     bool apply_trxs = true;
                     uint32_t applied_txs = 0;
                     uint32_t postponed_txs = 0;
-                    for (const auto &tx : _db._popped_tx) {
+                    for (const auto &popped_tx : _db._popped_tx) {
                         if( apply_trxs && fc::time_point::now() - start > CHAIN_PENDING_TRANSACTION_EXECUTION_LIMIT ) apply_trxs = false;
 
+                        precomputed_transaction tx(popped_tx);
+
                         if( apply_trxs )
                         {
                             try {
@@ -60,7 +62,7 @@ namespace graphene {
                         }
                     }
                     _db._popped_tx.clear();
-                    for (const signed_transaction &tx : _pending_transactions) {
+                    for (const auto &tx : _pending_transactions) {
                         if( apply_trxs && fc::time_point::now() - start > CHAIN_PENDING_TRANSACTION_EXECUTION_LIMIT ) apply_trxs = false;
 
                         if( apply_trxs ) {
@@ -77,7 +79,7 @@ namespace graphene {
                                 dlog( "Pending transaction became invalid after switching to block ${b} ${n} ${t}",
                                     ("b", _db.head_block_id())("n", _db.head_block_num())("t", _db.head_block_time()) );
                                 dlog( "The invalid transaction caused exception ${e}", ("e", e.to_detail_string()) );
-                                dlog( "${t}", ("t", tx) );
+                                dlog( "${t}", ("t", tx.transaction()) );
                             }
                             catch( const fc::exception& e )
                             {
@@ -101,7 +103,7 @@ namespace graphene {
 
                 database &_db;
                 uint32_t _skip;
-                std::vector<signed_transaction> _pending_transactions;
+                std::vector<precomputed_transaction> _pending_transactions;
             };
 
             /**
@@ -129,7 +131,7 @@ namespace graphene {
             void without_pending_transactions(
                 database& db,
                 uint32_t skip,
-                std::vector<signed_transaction>&& pending_transactions,
+                std::vector<precomputed_transaction>&& pending_transactions,
                 Lambda callback
             ) {
                 pending_transactions_restorer restorer(db, skip, std::move(pending_transactions));
@@ -2,12 +2,128 @@
 
 #include <graphene/chain/database.hpp>
 
+#include <algorithm>
+
 namespace graphene {
     namespace chain {
 
+        namespace detail {
+
+            struct snapshot_member {
+                std::string name;
+                size_t offset;
+                size_t size;
+                size_t align;
+            };
+
+            template<typename T>
+            struct snapshot_member_visitor {
+                const T &object;
+                std::vector<snapshot_member> &members;
+
+                template<typename Member, class Class, Member (Class::*member)>
+                void operator()(const char *name) const {
+                    const char *begin = reinterpret_cast<const char *>(&object);
+                    const char *field = reinterpret_cast<const char *>(&(object.*member));
+                    members.push_back({name, size_t(field - begin), sizeof(Member), alignof(Member)});
+                }
+            };
+
+            inline size_t align_up(size_t offset, size_t align) {
+                return (offset + align - 1) / align * align;
+            }
+
+            /**
+             * Objects are stored in the state snapshot only by their reflected members, so a member missing in FC_REFLECT
+             *   is silently lost on import. Check that the reflected members cover the whole object except the padding.
+             */
+            template<typename T>
+            void verify_snapshot_reflection(const T &o, const std::string &type_name) {
+                std::vector<snapshot_member> members;
+                fc::reflector<T>::visit(snapshot_member_visitor<T>{o, members});
+                std::sort(members.begin(), members.end(), [](const snapshot_member &a, const snapshot_member &b) {
+                    return a.offset < b.offset;
+                });
+
+                size_t end = 0;
+                for (const auto &m : members) {
+                    FC_ASSERT(m.offset <= align_up(end, m.align),
+                        "Bytes ${b}..${e} of ${t} aren't covered by FC_REFLECT (before member ${m}), "
+                        "they would be lost in state snapshot",
+                        ("b", end)("e", m.offset)("t", type_name)("m", m.name));
+                    end = std::max(end, m.offset + m.size);
+                }
+                FC_ASSERT(align_up(end, alignof(T)) == sizeof(T),
+                    "Bytes ${b}..${e} of ${t} aren't covered by FC_REFLECT, they would be lost in state snapshot",
+                    ("b", end)("e", sizeof(T))("t", type_name));
+            }
+
+        }
+
+        /**
+         * Exports and imports objects of the index for the state snapshot.
+         * Objects are serialized via fc::raw, so the object type should be reflected.
+         */
+        template<typename MultiIndexType>
+        class snapshot_index final: public abstract_snapshot_index {
+        public:
+            using value_type = typename MultiIndexType::value_type;
+            using id_type = typename value_type::id_type;
+
+            std::string name() const override {
+                return fc::get_typename<value_type>::name();
+            }
+
+            uint64_t size(const database &db) const override {
+                return db.get_index<MultiIndexType>().indices().size();
+            }
+
+            void export_objects(const database &db, state_snapshot_writer &out) const override {
+                const auto &idx = db.get_index<MultiIndexType>().indices();
+                if (!idx.empty()) {
+                    detail::verify_snapshot_reflection(*idx.begin(), name());
+                }
+
+                // the first index of each container is ordered by id
+                for (const auto &o : idx) {
+                    out.write_object(fc::raw::pack(o));
+                }
+            }
+
+            void import_objects(database &db, state_snapshot_reader &in, uint64_t count) const override {
+                std::vector<char> data;
+                optional<id_type> last_id;
+                for (uint64_t i = 0; i < count; ++i) {
+                    in.read_object(data);
+
+                    // the object keeps its stored id, ids of removed objects are skipped
+                    const auto &o = db.create<value_type>([&](value_type &v) {
+                        fc::raw::unpack(data, v);
+                    });
+                    FC_ASSERT(!last_id || *last_id < o.id,
+                        "Objects of ${t} aren't ordered by id in state snapshot", ("t", name()));
+                    last_id = o.id;
+
+                    if (i == 0) {
+                        detail::verify_snapshot_reflection(o, name());
+                    }
+                    // the imported object should be exported back to the same bytes
+                    FC_ASSERT(fc::raw::pack(o) == data,
+                        "Object ${id} of ${t} differs after import from state snapshot",
+                        ("id", o.id)("t", name()));
+                }
+
+                // new objects continue the ids after the last stored object
+                if (last_id) {
+                    db.get_mutable_index<MultiIndexType>().set_next_id(id_type(last_id->_id + 1));
+                }
+            }
+        };
+
         template<typename MultiIndexType>
         void _add_index_impl(database &db) {
             db.add_index<MultiIndexType>();
+            db.add_snapshot_index(std::make_unique<snapshot_index<MultiIndexType>>());
         }
 
         template<typename MultiIndexType>
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <graphene/chain/precomputed_transaction.hpp>
+#include <graphene/protocol/block.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        using graphene::protocol::signed_block;
+        using graphene::protocol::block_id_type;
+
+        /**
+         * Block with hashes which are calculated before applying of the block.
+         * It allows to move the hashing out of the write thread (e.g. on replaying of the block log).
+         *
+         * Precomputed transactions refer to transactions of the block, so the object can be moved but not copied.
+         */
+        struct precomputed_block {
+            precomputed_block() = default;
+
+            explicit precomputed_block(signed_block b);
+
+            precomputed_block(const precomputed_block &) = delete;
+            precomputed_block &operator=(const precomputed_block &) = delete;
+
+            precomputed_block(precomputed_block &&) = default;
+            precomputed_block &operator=(precomputed_block &&) = default;
+
+            signed_block block;
+            block_id_type block_id;
+            std::vector<precomputed_transaction> transactions;
+        };
+
+    }
+} // graphene::chain
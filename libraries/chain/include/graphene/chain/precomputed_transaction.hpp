@@ -0,0 +1,75 @@
+#pragma once
+
+#include <graphene/protocol/transaction.hpp>
+
+#include <memory>
+
+namespace graphene {
+    namespace chain {
+
+        using graphene::protocol::signed_transaction;
+        using graphene::protocol::transaction_id_type;
+        using graphene::protocol::digest_type;
+
+        /**
+         * Signed transaction with its serialized form and hashes.
+         *
+         * The transaction is packed only once on construction, and the id, the digest for signatures,
+         * the digest of the signed transaction and the packed size are calculated from the packed bytes.
+         * The object is passed through push_transaction() -> _push_transaction() -> _apply_transaction(),
+         * so the hot paths don't repeat the serialization and the hashing.
+         */
+        class precomputed_transaction final {
+        public:
+            /**
+             * Takes ownership of the transaction
+             */
+            explicit precomputed_transaction(signed_transaction trx);
+
+            explicit precomputed_transaction(std::shared_ptr<const signed_transaction> trx);
+
+            /**
+             * Doesn't take ownership of the transaction, it should outlive the result (e.g. a transaction of the block)
+             */
+            static precomputed_transaction refer_to(const signed_transaction &trx);
+
+            const signed_transaction &transaction() const {
+                return *_trx;
+            }
+
+            const transaction_id_type &id() const {
+                return _id;
+            }
+
+            /**
+             * Digest of the transaction with the chain id, which is signed by keys
+             */
+            const digest_type &sig_digest() const {
+                return _sig_digest;
+            }
+
+            /**
+             * Digest of the signed transaction, the same as signed_transaction::merkle_digest()
+             */
+            const digest_type &merkle_digest() const {
+                return _merkle_digest;
+            }
+
+            const std::vector<char> &packed() const {
+                return _packed;
+            }
+
+            std::size_t packed_size() const {
+                return _packed.size();
+            }
+
+        private:
+            std::shared_ptr<const signed_transaction> _trx;
+            std::vector<char> _packed;
+            transaction_id_type _id;
+            digest_type _sig_digest;
+            digest_type _merkle_digest;
+        };
+
+    }
+} // graphene::chain
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <graphene/protocol/block.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        using graphene::protocol::block_id_type;
+
+        /**
+         * Manifest of the checkpoint of a replay which was stopped by a signal.
+         *
+         * The manifest is written next to the shared memory file after the state is flushed,
+         * and it is removed when the replay finishes. On restart the state should match it,
+         * and the replay continues from the next block.
+         */
+        struct replay_checkpoint {
+            uint32_t block_num = 0;
+            block_id_type block_id;
+            fc::time_point_sec block_time;
+            uint32_t last_block_num = 0; ///< head of the block log on the replay
+            fc::time_point_sec created;
+        };
+
+        inline fc::path replay_checkpoint_path(const fc::path &shared_mem_dir) {
+            return shared_mem_dir / "replay_checkpoint.json";
+        }
+
+        /**
+         * The marker exists while replay applies blocks.
+         * If it exists on open, the replay was killed and the state can't be trusted.
+         */
+        inline fc::path replay_dirty_path(const fc::path &shared_mem_dir) {
+            return shared_mem_dir / "replay_checkpoint.dirty";
+        }
+
+    }
+} // graphene::chain
+
+FC_REFLECT(graphene::chain::replay_checkpoint, (block_num)(block_id)(block_time)(last_block_num)(created))
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <graphene/chain/precomputed_transaction.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace graphene {
+    namespace chain {
+
+        using graphene::protocol::public_key_type;
+
+        /**
+         * Public keys which were recovered from signatures of transactions.
+         *
+         * The ECDSA recovery is the most expensive part of the authority check. The cache allows to do the recovery
+         * in parallel threads without locking of database (e.g. before pushing of a block), and then the authority
+         * check in the write thread only walks through the authority graph.
+         *
+         * The cache is keyed by the digest of the signed transaction, so any change of signatures is a cache miss.
+         * Entries live until the expiration of transactions. All methods are thread-safe.
+         */
+        class signature_keys_cache final {
+        public:
+            /**
+             * Recover keys from signatures and store them in the cache
+             */
+            void precompute(const precomputed_transaction &trx);
+
+            /**
+             * @return cached keys or recovered keys, if the transaction isn't in the cache
+             */
+            fc::flat_set<public_key_type> get(const precomputed_transaction &trx);
+
+            void remove_expired(fc::time_point_sec now);
+
+            void clear();
+
+            std::size_t size() const;
+
+            static constexpr std::size_t max_size = 500000;
+
+        private:
+            struct entry_type {
+                fc::flat_set<public_key_type> keys;
+                fc::time_point_sec expiration;
+            };
+
+            static fc::flat_set<public_key_type> recover(const precomputed_transaction &trx);
+
+            void remove_front();
+
+            mutable std::mutex _mutex;
+            std::map<digest_type, entry_type> _entries;
+            std::multimap<fc::time_point_sec, digest_type> _expirations;
+        };
+
+    }
+} // graphene::chain
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <graphene/protocol/types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace chain {
+
+        using graphene::protocol::block_id_type;
+        using graphene::protocol::chain_id_type;
+
+        class database;
+
+        /**
+         * Header of the state snapshot file, it follows the magic and it's followed by the index sections.
+         *
+         * Each section contains the name of the object type, the number of objects,
+         * the objects in ascending order of ids (each object is prefixed by its size),
+         * and the sha256 of the section data.
+         */
+        struct state_snapshot_header {
+            static constexpr uint32_t current_version = 2;
+
+            uint32_t version = current_version;
+            chain_id_type chain_id;
+            uint32_t head_block_num = 0;
+            block_id_type head_block_id;
+            fc::time_point_sec head_block_time;
+            uint32_t index_count = 0;
+        };
+
+        class state_snapshot_writer final {
+        public:
+            explicit state_snapshot_writer(const fc::path& path);
+
+            void write_header(const state_snapshot_header& header);
+
+            void begin_section(const std::string& name, uint64_t count);
+
+            void write_object(const std::vector<char>& data);
+
+            void end_section();
+
+            void close();
+
+        private:
+            void write(const char* data, size_t size);
+
+            std::ofstream _out;
+            fc::sha256::encoder _checksum;
+        };
+
+        class state_snapshot_reader final {
+        public:
+            explicit state_snapshot_reader(const fc::path& path);
+
+            state_snapshot_header read_header();
+
+            /**
+             * Reads the name of the next section and the number of objects in it,
+             * and verifies the checksum of the section before its objects are read
+             */
+            void begin_section(std::string& name, uint64_t& count);
+
+            void read_object(std::vector<char>& data);
+
+            /**
+             * Skips the checksum after the objects of the section
+             */
+            void end_section();
+
+        private:
+            void read(char* data, size_t size);
+
+            uint32_t read_size();
+
+            std::ifstream _in;
+            fc::sha256::encoder _checksum;
+            bool _verifying = true;
+        };
+
+        /**
+         * Exports and imports objects of an index, see snapshot_index in index.hpp
+         */
+        class abstract_snapshot_index {
+        public:
+            virtual ~abstract_snapshot_index() = default;
+
+            virtual std::string name() const = 0;
+
+            virtual uint64_t size(const database& db) const = 0;
+
+            virtual void export_objects(const database& db, state_snapshot_writer& out) const = 0;
+
+            virtual void import_objects(database& db, state_snapshot_reader& in, uint64_t count) const = 0;
+        };
+
+    }
+} // graphene::chain
+
+FC_REFLECT(
+    (graphene::chain::state_snapshot_header),
+    (version)(chain_id)(head_block_num)(head_block_id)(head_block_time)(index_count))
@@ -0,0 +1,16 @@
+#include <graphene/chain/precomputed_block.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        precomputed_block::precomputed_block(signed_block b)
+            : block(std::move(b)),
+              block_id(block.id()) {
+            transactions.reserve(block.transactions.size());
+            for (const auto& trx : block.transactions) {
+                transactions.push_back(precomputed_transaction::refer_to(trx));
+            }
+        }
+
+    }
+} // graphene::chain
@@ -0,0 +1,36 @@
+#include <graphene/chain/precomputed_transaction.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        precomputed_transaction::precomputed_transaction(signed_transaction trx)
+            : precomputed_transaction(std::make_shared<const signed_transaction>(std::move(trx))) {
+        }
+
+        precomputed_transaction::precomputed_transaction(std::shared_ptr<const signed_transaction> trx)
+            : _trx(std::move(trx)),
+              _packed(fc::raw::pack(*_trx)) {
+            // signed_transaction is packed as the transaction followed by the signatures,
+            //   so the unsigned part is a prefix of the packed bytes
+            const auto trx_size = _packed.size() - fc::raw::pack_size(_trx->signatures);
+
+            auto digest = digest_type::hash(_packed.data(), trx_size);
+            memcpy(_id._hash, digest._hash, std::min(sizeof(_id), sizeof(digest)));
+
+            static const graphene::protocol::chain_id_type chain_id = CHAIN_ID;
+
+            digest_type::encoder enc;
+            fc::raw::pack(enc, chain_id);
+            enc.write(_packed.data(), trx_size);
+            _sig_digest = enc.result();
+
+            _merkle_digest = digest_type::hash(_packed.data(), _packed.size());
+        }
+
+        precomputed_transaction precomputed_transaction::refer_to(const signed_transaction &trx) {
+            // aliasing constructor with an empty owner doesn't manage the lifetime of the transaction
+            return precomputed_transaction(std::shared_ptr<const signed_transaction>(std::shared_ptr<const signed_transaction>(), &trx));
+        }
+
+    }
+} // graphene::chain
@@ -0,0 +1,79 @@
+#include <graphene/chain/signature_keys_cache.hpp>
+#include <graphene/protocol/exceptions.hpp>
+
+namespace graphene {
+    namespace chain {
+
+        fc::flat_set<public_key_type> signature_keys_cache::recover(const precomputed_transaction &trx) {
+            try {
+                fc::flat_set<public_key_type> result;
+                for (const auto &sig : trx.transaction().signatures) {
+                    CHAIN_ASSERT(
+                        result.insert(fc::ecc::public_key(sig, trx.sig_digest())).second,
+                        protocol::tx_duplicate_sig,
+                        "Duplicate Signature detected");
+                }
+                return result;
+            } FC_CAPTURE_AND_RETHROW()
+        }
+
+        void signature_keys_cache::precompute(const precomputed_transaction &trx) {
+            const auto &digest = trx.merkle_digest();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_entries.count(digest)) {
+                    return;
+                }
+            }
+
+            // recovering is done without lock
+            entry_type entry;
+            entry.keys = recover(trx);
+            entry.expiration = trx.transaction().expiration;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_entries.size() >= max_size) {
+                remove_front();
+            }
+            if (_entries.emplace(digest, std::move(entry)).second) {
+                _expirations.emplace(trx.transaction().expiration, digest);
+            }
+        }
+
+        fc::flat_set<public_key_type> signature_keys_cache::get(const precomputed_transaction &trx) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto itr = _entries.find(trx.merkle_digest());
+                if (itr != _entries.end()) {
+                    return itr->second.keys;
+                }
+            }
+            return recover(trx);
+        }
+
+        void signature_keys_cache::remove_expired(fc::time_point_sec now) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while (!_expirations.empty() && _expirations.begin()->first < now) {
+                remove_front();
+            }
+        }
+
+        void signature_keys_cache::remove_front() {
+            auto itr = _expirations.begin();
+            _entries.erase(itr->second);
+            _expirations.erase(itr);
+        }
+
+        void signature_keys_cache::clear() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _entries.clear();
+            _expirations.clear();
+        }
+
+        std::size_t signature_keys_cache::size() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _entries.size();
+        }
+
+    }
+} // graphene::chain
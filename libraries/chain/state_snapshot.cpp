@@ -0,0 +1,137 @@
+#include <graphene/chain/state_snapshot.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <cstring>
+
+namespace graphene {
+    namespace chain {
+
+        static const char state_snapshot_magic[8] = {'V', 'I', 'Z', 'S', 'T', 'A', 'T', 'E'};
+
+        state_snapshot_writer::state_snapshot_writer(const fc::path& path)
+            : _out(path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc) {
+            FC_ASSERT(_out.good(), "Can't create state snapshot ${p}", ("p", path));
+            _out.write(state_snapshot_magic, sizeof(state_snapshot_magic));
+        }
+
+        void state_snapshot_writer::write(const char* data, size_t size) {
+            _out.write(data, size);
+            _checksum.write(data, size);
+            FC_ASSERT(_out.good(), "Can't write state snapshot");
+        }
+
+        void state_snapshot_writer::write_header(const state_snapshot_header& header) {
+            auto data = fc::raw::pack(header);
+            write(data.data(), data.size());
+        }
+
+        void state_snapshot_writer::begin_section(const std::string& name, uint64_t count) {
+            _checksum.reset();
+            auto data = fc::raw::pack(name);
+            write(data.data(), data.size());
+            write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+
+        void state_snapshot_writer::write_object(const std::vector<char>& data) {
+            auto size = fc::raw::pack(fc::unsigned_int(static_cast<uint32_t>(data.size())));
+            write(size.data(), size.size());
+            write(data.data(), data.size());
+        }
+
+        void state_snapshot_writer::end_section() {
+            auto checksum = _checksum.result();
+            _out.write(checksum.data(), checksum.data_size());
+            FC_ASSERT(_out.good(), "Can't write state snapshot");
+        }
+
+        void state_snapshot_writer::close() {
+            _out.flush();
+            FC_ASSERT(_out.good(), "Can't write state snapshot");
+            _out.close();
+        }
+
+        state_snapshot_reader::state_snapshot_reader(const fc::path& path)
+            : _in(path.generic_string(), std::ios::in | std::ios::binary) {
+            FC_ASSERT(_in.good(), "Can't open state snapshot ${p}", ("p", path));
+
+            char magic[sizeof(state_snapshot_magic)];
+            _in.read(magic, sizeof(magic));
+            FC_ASSERT(_in.good() && std::memcmp(magic, state_snapshot_magic, sizeof(magic)) == 0,
+                "${p} isn't a state snapshot", ("p", path));
+        }
+
+        void state_snapshot_reader::read(char* data, size_t size) {
+            _in.read(data, size);
+            FC_ASSERT(_in.good(), "Unexpected end of state snapshot");
+            if (_verifying) {
+                _checksum.write(data, size);
+            }
+        }
+
+        uint32_t state_snapshot_reader::read_size() {
+            // unsigned_int is packed as varint, it takes up to 5 bytes
+            std::vector<char> data;
+            char byte = 0;
+            do {
+                read(&byte, 1);
+                data.push_back(byte);
+            } while ((byte & 0x80) && data.size() < 5);
+            return fc::raw::unpack<fc::unsigned_int>(data).value;
+        }
+
+        state_snapshot_header state_snapshot_reader::read_header() {
+            // all fields of the header have the fixed size
+            std::vector<char> data(fc::raw::pack_size(state_snapshot_header()));
+            read(data.data(), data.size());
+
+            auto header = fc::raw::unpack<state_snapshot_header>(data);
+            FC_ASSERT(header.version == state_snapshot_header::current_version,
+                "Unsupported version ${v} of state snapshot", ("v", header.version));
+            return header;
+        }
+
+        void state_snapshot_reader::begin_section(std::string& name, uint64_t& count) {
+            _checksum.reset();
+            _verifying = true;
+
+            name.resize(read_size());
+            if (!name.empty()) {
+                read(&name[0], name.size());
+            }
+            read(reinterpret_cast<char*>(&count), sizeof(count));
+
+            // the section is read twice: to verify the checksum and then to return the objects,
+            //   so nothing is inserted from a broken section and the section isn't kept in memory
+            auto objects_pos = _in.tellg();
+            std::vector<char> data;
+            for (uint64_t i = 0; i < count; ++i) {
+                read_object(data);
+            }
+            auto checksum = _checksum.result();
+
+            fc::sha256 stored;
+            _in.read(stored.data(), stored.data_size());
+            FC_ASSERT(_in.good(), "Unexpected end of state snapshot");
+            FC_ASSERT(stored == checksum, "Checksum of state snapshot section ${n} doesn't match", ("n", name));
+
+            _verifying = false;
+            _in.seekg(objects_pos);
+            FC_ASSERT(_in.good(), "Can't seek in state snapshot");
+        }
+
+        void state_snapshot_reader::read_object(std::vector<char>& data) {
+            data.resize(read_size());
+            if (!data.empty()) {
+                read(data.data(), data.size());
+            }
+        }
+
+        void state_snapshot_reader::end_section() {
+            // the checksum is already verified by begin_section()
+            _in.seekg(fc::sha256().data_size(), std::ios::cur);
+            FC_ASSERT(_in.good(), "Unexpected end of state snapshot");
+        }
+
+    }
+} // graphene::chain
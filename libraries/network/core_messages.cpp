@@ -23,12 +23,17 @@
  */
 #include <graphene/network/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene {
     namespace network {
 
         const core_message_type_enum trx_message::type = core_message_type_enum::trx_message_type;
         const core_message_type_enum block_message::type = core_message_type_enum::block_message_type;
+        const core_message_type_enum compact_block_message::type = core_message_type_enum::compact_block_message_type;
+        const core_message_type_enum get_compact_block_transactions_message::type = core_message_type_enum::get_compact_block_transactions_message_type;
+        const core_message_type_enum compact_block_transactions_message::type = core_message_type_enum::compact_block_transactions_message_type;
         const core_message_type_enum block_post_validation_message::type = core_message_type_enum::block_post_validation_message_type;
         const core_message_type_enum item_ids_inventory_message::type = core_message_type_enum::item_ids_inventory_message_type;
         const core_message_type_enum blockchain_item_ids_inventory_message::type = core_message_type_enum::blockchain_item_ids_inventory_message_type;
@@ -48,5 +53,20 @@ namespace graphene {
         const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
         const core_message_type_enum get_current_connections_reply_message::type = core_message_type_enum::get_current_connections_reply_message_type;
 
+        compact_block_message::compact_block_message(const signed_block &blk)
+                : header(blk) {
+            short_ids.reserve(blk.transactions.size());
+            for (const auto &trx : blk.transactions) {
+                short_ids.push_back(short_id(trx.id()));
+            }
+        }
+
+        uint64_t compact_block_message::short_id(const transaction_id_type &id) {
+            uint64_t result;
+            static_assert(sizeof(id._hash) >= sizeof(result), "transaction id is too short");
+            memcpy(&result, id._hash, sizeof(result));
+            return result;
+        }
+
     }
 } // graphene::network
@@ -23,7 +23,12 @@
  */
 #pragma once
 
-#define GRAPHENE_NET_PROTOCOL_VERSION                        106
+#define GRAPHENE_NET_PROTOCOL_VERSION                        107
+
+/**
+ * Peers starting from this version of the core protocol receive new blocks as compact_block_message
+ */
+#define GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION         107
 
 /**
  * Define this to enable debugging code in the p2p network interface.
@@ -103,3 +108,19 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+#define GRAPHENE_NET_DEFAULT_DECODE_THREADS                  2
+
+/**
+ * A peer can request transactions only of the last compact blocks we sent to it.
+ * It requests them at most twice per block: the missing ones, and all of them
+ * if the reconstructed block doesn't match its merkle root.
+ */
+#define GRAPHENE_NET_MAX_COMPACT_BLOCKS_SENT_PER_PEER        16
+#define GRAPHENE_NET_MAX_COMPACT_BLOCK_TRANSACTIONS_REQUESTS 2
+
+/**
+ * Blocks and other messages of at least this size are unpacked and hashed
+ * on the decode threads, smaller ones are cheaper to handle on the p2p thread
+ */
+#define GRAPHENE_NET_MIN_MESSAGE_SIZE_TO_DECODE_IN_POOL      1024
@@ -90,6 +90,9 @@ namespace graphene {
             check_firewall_reply_message_type = 5015,
             get_current_connections_request_message_type = 5016,
             get_current_connections_reply_message_type = 5017,
+            compact_block_message_type = 5018,
+            get_compact_block_transactions_message_type = 5019,
+            compact_block_transactions_message_type = 5020,
             core_message_type_last = 5099,
             block_post_validation_message_type = 6009,//just pass to process_ordinary_message
         };
@@ -124,6 +127,61 @@ namespace graphene {
 
         };
 
+        /**
+         * The block announced by the header and short ids of its transactions, peers usually have
+         * received these transactions just before the block, so they reconstruct the block themselves
+         * and request only the missing transactions by get_compact_block_transactions_message.
+         *
+         * It's sent instead of block_message only to peers with the core protocol version
+         * GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION or above, which requested the block during normal operation.
+         */
+        struct compact_block_message {
+            static const core_message_type_enum type;
+
+            compact_block_message() {
+            }
+
+            compact_block_message(const signed_block &blk);
+
+            /// the first 8 bytes of the transaction id
+            static uint64_t short_id(const transaction_id_type &id);
+
+            graphene::protocol::signed_block_header header;
+            std::vector<uint64_t> short_ids;
+        };
+
+        struct get_compact_block_transactions_message {
+            static const core_message_type_enum type;
+
+            get_compact_block_transactions_message() {
+            }
+
+            get_compact_block_transactions_message(const block_id_type &block_id, const std::vector<uint32_t> &indexes)
+                    :
+                    block_id(block_id),
+                    indexes(indexes) {
+            }
+
+            block_id_type block_id;
+            std::vector<uint32_t> indexes; /// positions of the requested transactions in the block, in ascending order
+        };
+
+        struct compact_block_transactions_message {
+            static const core_message_type_enum type;
+
+            compact_block_transactions_message() {
+            }
+
+            compact_block_transactions_message(const block_id_type &block_id, std::vector<signed_transaction> transactions)
+                    :
+                    block_id(block_id),
+                    transactions(std::move(transactions)) {
+            }
+
+            block_id_type block_id;
+            std::vector<signed_transaction> transactions; /// in the order of the requested indexes, empty if the block isn't available
+        };
+
         struct block_post_validation_message {
             static const core_message_type_enum type;
 
@@ -472,11 +530,17 @@ FC_REFLECT_ENUM(graphene::network::core_message_type_enum,
                 (check_firewall_reply_message_type)
                 (get_current_connections_request_message_type)
                 (get_current_connections_reply_message_type)
+                (compact_block_message_type)
+                (get_compact_block_transactions_message_type)
+                (compact_block_transactions_message_type)
                 (core_message_type_last)
                 (block_post_validation_message_type))
 
 FC_REFLECT((graphene::network::trx_message), (trx))
 FC_REFLECT((graphene::network::block_message), (block)(block_id))
+FC_REFLECT((graphene::network::compact_block_message), (header)(short_ids))
+FC_REFLECT((graphene::network::get_compact_block_transactions_message), (block_id)(indexes))
+FC_REFLECT((graphene::network::compact_block_transactions_message), (block_id)(transactions))
 FC_REFLECT((graphene::network::block_post_validation_message), (block_id)(witness_account)(witness_signature))
 
 FC_REFLECT((graphene::network::item_id), (item_type)
@@ -74,6 +74,15 @@ namespace graphene {
                 size = (uint32_t)data.size();
             }
 
+            /**
+             *  Creates the message from the already serialized content of type
+             */
+            message(uint32_t type, std::vector<char> &&content)
+                    : data(std::move(content)) {
+                msg_type = type;
+                size = (uint32_t)data.size();
+            }
+
             fc::uint160_t id() const {
                 return fc::ripemd160::hash(data.data(), (uint32_t)data.size());
             }
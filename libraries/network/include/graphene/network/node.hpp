@@ -113,6 +113,12 @@ namespace graphene {
              */
             virtual message get_item(const item_id &id) = 0;
 
+            /**
+             *  Returns transactions which are pending on the client, they are used
+             *  to reconstruct blocks received as compact_block_message.
+             */
+            virtual std::vector<signed_transaction> get_pending_transactions() = 0;
+
             /**
              * Returns a synopsis of the blockchain used for syncing.
              * This consists of a list of selected item hashes from our current preferred
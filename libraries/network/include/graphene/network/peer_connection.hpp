@@ -265,6 +265,22 @@ namespace graphene {
             timestamped_items_set_type inventory_advertised_to_peer;
 
             item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+            /// the block from a compact_block_message which waits for its missing transactions from this peer
+            struct compact_block_in_progress {
+                signed_block block;
+                block_id_type block_id;
+                std::vector<uint32_t> missing_transactions; /// indexes of transactions requested from the peer
+                bool all_transactions_requested = false;
+            };
+            fc::optional<compact_block_in_progress> compact_block_being_reconstructed;
+
+            /// the last blocks sent to this peer as compact blocks, the peer can request their transactions
+            struct compact_block_sent {
+                block_id_type block_id;
+                uint32_t transactions_requests = 0;
+            };
+            boost::container::deque<compact_block_sent> compact_blocks_sent_to_peer;
             /// @}
 
             // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -60,6 +60,12 @@ namespace graphene {
 
             virtual size_t writesome(const std::shared_ptr<const char> &buf, size_t len, size_t offset);
 
+            /**
+             * Encrypts the buffer in place and writes it entirely, len must be a multiple of 16.
+             * It saves the copy to the write buffer when the caller owns the data.
+             */
+            void write_in_place(const std::shared_ptr<char> &buf, size_t len);
+
             virtual void flush();
 
             virtual void close();
@@ -44,6 +44,9 @@
 namespace graphene {
     namespace network {
         namespace detail {
+            /// the read and send buffers larger than this are released after the message
+            const size_t max_kept_buffer_size = 256 * 1024;
+
             class message_oriented_connection_impl {
             private:
                 message_oriented_connection *_self;
@@ -59,6 +62,10 @@ namespace graphene {
 
                 bool _send_message_in_progress;
 
+                /// the padded message is encrypted in place, the buffer is reused by following messages
+                std::shared_ptr<char> _send_buffer;
+                size_t _send_buffer_size;
+
 #ifndef NDEBUG
                 fc::thread *_thread;
 #endif
@@ -108,7 +115,8 @@ namespace graphene {
                       _delegate(delegate),
                       _bytes_received(0),
                       _bytes_sent(0),
-                      _send_message_in_progress(false)
+                      _send_message_in_progress(false),
+                      _send_buffer_size(0)
 #ifndef NDEBUG
                     , _thread(&fc::thread::current())
 #endif
@@ -159,27 +167,30 @@ namespace graphene {
 
                 try {
                     message m;
+                    // the socket reads into owned buffers, so a read pending on cancel can't write into freed memory
+                    std::shared_ptr<char> header_buffer(new char[BUFFER_SIZE], [](char *p) { delete[] p; });
+                    // the body is decrypted in place and becomes the data of the message without copying,
+                    //   its storage is taken back after the message is handled
+                    auto body = std::make_shared<std::vector<char>>();
                     while (true) {
-                        char buffer[BUFFER_SIZE];
-                        _sock.read(buffer, BUFFER_SIZE);
+                        _sock.read(header_buffer, BUFFER_SIZE, 0);
                         _bytes_received += BUFFER_SIZE;
-                        memcpy((char *)&m, buffer, sizeof(message_header));
+                        memcpy((char *)&m, header_buffer.get(), sizeof(message_header));
 
                         FC_ASSERT(m.size <=
                                   MAX_MESSAGE_SIZE, "", ("m.size", m.size)("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE));
 
                         size_t remaining_bytes_with_padding =
                                 16 * ((m.size - LEFTOVER + 15) / 16);
-                        m.data.resize(LEFTOVER +
-                                      remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-                        std::copy(
-                                buffer + sizeof(message_header),
-                                buffer + sizeof(buffer), m.data.begin());
+                        body->resize(LEFTOVER +
+                                     remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
+                        memcpy(body->data(), header_buffer.get() + sizeof(message_header), LEFTOVER);
                         if (remaining_bytes_with_padding) {
-                            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+                            _sock.read(std::shared_ptr<char>(body, body->data()), remaining_bytes_with_padding, LEFTOVER);
                             _bytes_received += remaining_bytes_with_padding;
                         }
-                        m.data.resize(m.size); // truncate off the padding bytes
+                        body->resize(m.size); // truncate off the padding bytes
+                        m.data = std::move(*body);
 
                         _last_message_received_time = fc::time_point::now();
 
@@ -199,6 +210,12 @@ namespace graphene {
                             wlog("message transmission failed ${er}", ("er", e.to_detail_string()));
                             throw;
                         }
+
+                        // don't keep the memory of a rare large message for the whole connection
+                        if (m.data.capacity() <= max_kept_buffer_size) {
+                            *body = std::move(m.data);
+                        }
+                        m.data = std::vector<char>();
                     }
                 }
                 catch (const fc::canceled_exception &e) {
@@ -271,14 +288,26 @@ namespace graphene {
                     //pad the message we send to a multiple of 16 bytes
                     size_t size_with_padding =
                             16 * ((size_of_message_and_header + 15) / 16);
-                    std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-                    memcpy(padded_message.get(), (char *)&message_to_send, sizeof(message_header));
-                    memcpy(padded_message.get() +
+                    // the socket may still hold the buffer of a canceled write, don't reuse it then
+                    if (_send_buffer_size < size_with_padding || _send_buffer.use_count() > 1) {
+                        _send_buffer_size = std::max<size_t>(size_with_padding, 4096);
+                        _send_buffer.reset(new char[_send_buffer_size], [](char *p) { delete[] p; });
+                    }
+                    memcpy(_send_buffer.get(), (char *)&message_to_send, sizeof(message_header));
+                    memcpy(_send_buffer.get() +
                            sizeof(message_header), message_to_send.data.data(), message_to_send.size);
-                    _sock.write(padded_message.get(), size_with_padding);
+                    memset(_send_buffer.get() + size_of_message_and_header, 0,
+                           size_with_padding - size_of_message_and_header);
+                    _sock.write_in_place(_send_buffer, size_with_padding);
                     _sock.flush();
                     _bytes_sent += size_with_padding;
                     _last_message_sent_time = fc::time_point::now();
+
+                    // don't keep the memory of a rare large message for the whole connection
+                    if (_send_buffer_size > max_kept_buffer_size) {
+                        _send_buffer.reset();
+                        _send_buffer_size = 0;
+                    }
                 } FC_RETHROW_EXCEPTIONS(warn, "unable to send message");
             }
 
@@ -25,6 +25,10 @@
 #include <iomanip>
 #include <deque>
 #include <unordered_set>
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
 #include <list>
 #include <forward_list>
 #include <iostream>
@@ -128,6 +132,7 @@ namespace graphene {
                     // for network performance stats
                     message_propagation_data propagation_data;
                     fc::uint160_t message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+                    fc::optional<message> compact_message_body; // compact_block_message of a block, it's made on the first request
 
                     message_info(const message_hash_type &message_hash,
                             const message &message_body,
@@ -168,6 +173,17 @@ namespace graphene {
 
                 message get_message(const message_hash_type &hash_of_message_to_lookup);
 
+                /// returns the block id or the transaction id of the cached message without copying and unpacking it
+                fc::optional<fc::uint160_t> get_message_contents_hash(const message_hash_type &hash_of_message_to_lookup) const;
+
+                /// returns compact_block_message of the cached block, or nothing if the block has no transactions
+                fc::optional<message> get_compact_block_message(const message_hash_type &hash_of_message_to_lookup);
+
+                fc::optional<message> get_message_by_contents_hash(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
+
+                /// looks up a cached transaction by compact_block_message::short_id of its id
+                fc::optional<signed_transaction> find_transaction(uint64_t short_id) const;
+
                 message_propagation_data get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
 
                 size_t size() const {
@@ -204,6 +220,59 @@ namespace graphene {
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
+            fc::optional<fc::uint160_t> blockchain_tied_message_cache::get_message_contents_hash(const message_hash_type &hash_of_message_to_lookup) const {
+                message_cache_container::index<message_hash_index>::type::const_iterator iter =
+                        _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup);
+                if (iter != _message_cache.get<message_hash_index>().end()) {
+                    return iter->message_contents_hash;
+                }
+                return fc::optional<fc::uint160_t>();
+            }
+
+            fc::optional<message> blockchain_tied_message_cache::get_compact_block_message(const message_hash_type &hash_of_message_to_lookup) {
+                auto &index = _message_cache.get<message_hash_index>();
+                auto iter = index.find(hash_of_message_to_lookup);
+                if (iter == index.end() || iter->message_body.msg_type != block_message_type) {
+                    return fc::optional<message>();
+                }
+                if (!iter->compact_message_body) {
+                    block_message cached_block = iter->message_body.as<block_message>();
+                    if (cached_block.block.transactions.empty()) {
+                        return fc::optional<message>();
+                    }
+                    message compact_message = compact_block_message(cached_block.block);
+                    index.modify(iter, [&](message_info &info) {
+                        info.compact_message_body = std::move(compact_message);
+                    });
+                }
+                return iter->compact_message_body;
+            }
+
+            fc::optional<message> blockchain_tied_message_cache::get_message_by_contents_hash(const fc::uint160_t &hash_of_message_contents_to_lookup) const {
+                auto &index = _message_cache.get<message_contents_hash_index>();
+                auto iter = index.find(hash_of_message_contents_to_lookup);
+                if (iter != index.end()) {
+                    return iter->message_body;
+                }
+                return fc::optional<message>();
+            }
+
+            fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction(uint64_t short_id) const {
+                // short id is the prefix of the transaction id, so the ids with it follow the id padded with zeros
+                fc::uint160_t lower_bound_hash;
+                memcpy(lower_bound_hash._hash, &short_id, sizeof(short_id));
+
+                auto &index = _message_cache.get<message_contents_hash_index>();
+                for (auto iter = index.lower_bound(lower_bound_hash);
+                     iter != index.end() && memcmp(iter->message_contents_hash._hash, &short_id, sizeof(short_id)) == 0;
+                     ++iter) {
+                    if (iter->message_body.msg_type == trx_message_type) {
+                        return iter->message_body.as<trx_message>().trx;
+                    }
+                }
+                return fc::optional<signed_transaction>();
+            }
+
             message_propagation_data blockchain_tied_message_cache::get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const {
                 if (hash_of_message_contents_to_lookup != fc::uint160_t()) {
                     message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
@@ -292,6 +361,7 @@ namespace graphene {
                                    (handle_transaction) \
                                    (get_block_ids) \
                                    (get_item) \
+                                   (get_pending_transactions) \
                                    (get_blockchain_synopsis) \
                                    (sync_status) \
                                    (connection_count_changed) \
@@ -399,6 +469,8 @@ namespace graphene {
 
                 message get_item(const item_id &id) override;
 
+                std::vector<signed_transaction> get_pending_transactions() override;
+
                 std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t &reference_point,
                         uint32_t number_of_blocks_after_reference_point) override;
 
@@ -463,8 +535,9 @@ namespace graphene {
                 typedef std::unordered_map<graphene::network::block_id_type, fc::time_point> active_sync_requests_map;
 
                 active_sync_requests_map _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
-                std::list<graphene::network::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
-                std::list<graphene::network::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
+                typedef std::unordered_map<graphene::network::block_id_type, graphene::network::block_message> received_sync_items_map;
+
+                received_sync_items_map _received_sync_items; /// sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
                 // @}
 
                 fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -592,6 +665,15 @@ namespace graphene {
                 unsigned _maximum_number_of_sync_blocks_to_prefetch;
                 unsigned _maximum_blocks_per_peer_during_syncing;
 
+                /// unpacking and hashing of large messages, the p2p thread serves other peers while they're decoded
+                std::vector<std::shared_ptr<fc::thread>> _decode_threads;
+                uint32_t _next_decode_thread;
+
+                void set_number_of_decode_threads(uint32_t number_of_threads);
+
+                template <typename Task>
+                void decode_message(const message &received_message, Task &&task);
+
                 std::list<fc::future<void>> _handle_message_calls_in_progress;
                 std::set<message_hash_type> _message_ids_currently_being_processed;
 
@@ -686,6 +768,19 @@ namespace graphene {
                 void on_fetch_items_message(peer_connection *originating_peer,
                         const fetch_items_message &fetch_items_message_received);
 
+                void send_requested_blocks(peer_connection *originating_peer, const std::vector<item_hash_t> &items_to_fetch);
+
+                void on_compact_block_message(peer_connection *originating_peer,
+                        const compact_block_message &compact_block_message_received);
+
+                void on_get_compact_block_transactions_message(peer_connection *originating_peer,
+                        const get_compact_block_transactions_message &get_compact_block_transactions_message_received);
+
+                void on_compact_block_transactions_message(peer_connection *originating_peer,
+                        const compact_block_transactions_message &compact_block_transactions_message_received);
+
+                void process_compact_block(peer_connection *originating_peer);
+
                 void on_item_not_available_message(peer_connection *originating_peer,
                         const item_not_available_message &item_not_available_message_received);
 
@@ -727,7 +822,7 @@ namespace graphene {
 
                 void process_block_during_normal_operation(peer_connection *originating_peer, const graphene::network::block_message &block_message, const message_hash_type &message_hash);
 
-                void process_block_message(peer_connection *originating_peer, const message &message_to_process, const message_hash_type &message_hash);
+                void process_block_message(peer_connection *originating_peer, const graphene::network::block_message &block_message_to_process, const message_hash_type &message_hash);
 
                 void process_ordinary_message(peer_connection *originating_peer, const message &message_to_process, const message_hash_type &message_hash);
 
@@ -899,8 +994,14 @@ namespace graphene {
                     _node_is_shutting_down(false),
                     _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
                     _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING) {
+                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+                    _next_decode_thread(0) {
                 _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
+                // the constructor doesn't run on the p2p thread, so the threads are created here directly
+                //   instead of set_number_of_decode_threads(), which must be called on the p2p thread
+                for (uint32_t i = 0; i < GRAPHENE_NET_DEFAULT_DECODE_THREADS; ++i) {
+                    _decode_threads.push_back(std::make_shared<fc::thread>("p2p_decode_" + std::to_string(i)));
+                }
                 fc::rand_bytes(&_node_id.data[0], (int)_node_id.size());
             }
 
@@ -1056,14 +1157,7 @@ namespace graphene {
 
             bool node_impl::have_already_received_sync_item(const item_hash_t &item_hash) {
                 VERIFY_CORRECT_THREAD();
-                return std::find_if(_received_sync_items.begin(), _received_sync_items.end(),
-                        [&item_hash](const graphene::network::block_message &message) {
-                            return message.block_id == item_hash;
-                        }) != _received_sync_items.end() ||
-                       std::find_if(_new_received_sync_items.begin(), _new_received_sync_items.end(),
-                               [&item_hash](const graphene::network::block_message &message) {
-                                   return message.block_id == item_hash;
-                               }) != _new_received_sync_items.end();;
+                return _received_sync_items.find(item_hash) != _received_sync_items.end();
             }
 
             void node_impl::request_sync_item_from_peer(const peer_connection_ptr &peer, const item_hash_t &item_to_request) {
@@ -1881,9 +1975,52 @@ namespace graphene {
                 }
             }
 
+            void node_impl::set_number_of_decode_threads(uint32_t number_of_threads) {
+                VERIFY_CORRECT_THREAD();
+                // a thread which is dropped here is kept alive by the fiber waiting for it
+                while (_decode_threads.size() > number_of_threads) {
+                    _decode_threads.pop_back();
+                }
+                while (_decode_threads.size() < number_of_threads) {
+                    _decode_threads.push_back(std::make_shared<fc::thread>(
+                            "p2p_decode_" + std::to_string(_decode_threads.size())));
+                }
+            }
+
+            template <typename Task>
+            void node_impl::decode_message(const message &received_message, Task &&task) {
+                VERIFY_CORRECT_THREAD();
+                if (_decode_threads.empty() || received_message.size < GRAPHENE_NET_MIN_MESSAGE_SIZE_TO_DECODE_IN_POOL) {
+                    task();
+                    return;
+                }
+                std::shared_ptr<fc::thread> decode_thread = _decode_threads[_next_decode_thread++ % _decode_threads.size()];
+                decode_thread->async(std::forward<Task>(task), "decode message").wait();
+            }
+
             void node_impl::on_message(peer_connection *originating_peer, const message &received_message) {
                 VERIFY_CORRECT_THREAD();
-                message_hash_type message_hash = received_message.id();
+                message_hash_type message_hash;
+                fc::optional<graphene::network::block_message> block_message_to_process;
+                if (received_message.msg_type == core_message_type_enum::block_message_type ||
+                    received_message.msg_type < core_message_type_enum::core_message_type_first ||
+                    received_message.msg_type > core_message_type_enum::core_message_type_last) {
+                    // the peer can be closed while this fiber waits for the decode thread
+                    peer_connection_ptr originating_peer_ptr = originating_peer->shared_from_this();
+                    decode_message(received_message, [&]() {
+                        message_hash = received_message.id();
+                        if (received_message.msg_type == core_message_type_enum::block_message_type) {
+                            block_message_to_process = received_message.as<graphene::network::block_message>();
+                        }
+                    });
+                    if (originating_peer->negotiation_status == peer_connection::connection_negotiation_status::closed) {
+                        dlog("peer ${endpoint} was closed while its message was decoded",
+                                ("endpoint", originating_peer->get_remote_endpoint()));
+                        return;
+                    }
+                } else {
+                    message_hash = received_message.id();
+                }
                 dlog("handling message ${type} ${hash} size ${size} from peer ${endpoint}",
                         ("type", graphene::network::core_message_type_enum(received_message.msg_type))("hash", message_hash)
                                 ("size", received_message.size)
@@ -1923,7 +2060,7 @@ namespace graphene {
                         on_closing_connection_message(originating_peer, received_message.as<closing_connection_message>());
                         break;
                     case core_message_type_enum::block_message_type:
-                        process_block_message(originating_peer, received_message, message_hash);
+                        process_block_message(originating_peer, *block_message_to_process, message_hash);
                         break;
                     case core_message_type_enum::current_time_request_message_type:
                         on_current_time_request_message(originating_peer, received_message.as<current_time_request_message>());
@@ -1943,6 +2080,15 @@ namespace graphene {
                     case core_message_type_enum::get_current_connections_reply_message_type:
                         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
                         break;
+                    case core_message_type_enum::compact_block_message_type:
+                        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+                        break;
+                    case core_message_type_enum::get_compact_block_transactions_message_type:
+                        on_get_compact_block_transactions_message(originating_peer, received_message.as<get_compact_block_transactions_message>());
+                        break;
+                    case core_message_type_enum::compact_block_transactions_message_type:
+                        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+                        break;
 
                     default:
                         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -2834,7 +2980,10 @@ namespace graphene {
                                 ("type", fetch_items_message_received.item_type)
                                 ("endpoint", originating_peer->get_remote_endpoint()));
 
-                fc::optional<message> last_block_message_sent;
+                if (fetch_items_message_received.item_type == block_message_type) {
+                    send_requested_blocks(originating_peer, fetch_items_message_received.items_to_fetch);
+                    return;
+                }
 
                 std::list<message> reply_messages;
                 for (const item_hash_t &item_hash : fetch_items_message_received.items_to_fetch) {
@@ -2842,12 +2991,8 @@ namespace graphene {
                         message requested_message = _message_cache.get_message(item_hash);
                         dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                                 ("endpoint", originating_peer->get_remote_endpoint())
-                                        ("id", requested_message.id()));
+                                        ("id", item_hash));
                         reply_messages.push_back(requested_message);
-                        if (fetch_items_message_received.item_type ==
-                            block_message_type) {
-                                last_block_message_sent = requested_message;
-                        }
                         continue;
                     }
                     catch (fc::key_not_found_exception &) {
@@ -2858,14 +3003,10 @@ namespace graphene {
                     try {
                         message requested_message = _delegate->get_item(item_to_fetch);
                         dlog("received item request from peer ${endpoint}, returning the item from delegate with id ${id} size ${size}",
-                                ("id", requested_message.id())
+                                ("id", item_hash)
                                         ("size", requested_message.size)
                                         ("endpoint", originating_peer->get_remote_endpoint()));
                         reply_messages.push_back(requested_message);
-                        if (fetch_items_message_received.item_type ==
-                            block_message_type) {
-                                last_block_message_sent = requested_message;
-                        }
                         continue;
                     }
                     catch (fc::key_not_found_exception &) {
@@ -2875,20 +3016,248 @@ namespace graphene {
                     }
                 }
 
+                for (const message &reply : reply_messages) {
+                    originating_peer->send_message(reply);
+                }
+            }
+
+            void node_impl::send_requested_blocks(peer_connection *originating_peer, const std::vector<item_hash_t> &items_to_fetch) {
+                VERIFY_CORRECT_THREAD();
+                // blocks are queued by id and loaded only when they're sent, so their ids are found without
+                // loading them: a block from the message cache is requested by the message hash and its id
+                // is cached along with it, a block from the delegate is requested by its id
+                fc::optional<block_id_type> last_block_id_sent;
+
+                // a reply is either a message made here (a compact block or item_not_available_message),
+                //   or a block which is loaded when it's sent, replies keep the order of requests
+                std::list<std::pair<item_id, fc::optional<message>>> replies;
+                for (const item_hash_t &item_hash : items_to_fetch) {
+                    fc::optional<fc::uint160_t> block_id = _message_cache.get_message_contents_hash(item_hash);
+                    if (block_id) {
+                        dlog("received block request for item ${id} from peer ${endpoint}, returning the block ${block_id} from my message cache",
+                                ("endpoint", originating_peer->get_remote_endpoint())
+                                        ("id", item_hash)("block_id", *block_id));
+                        // a new block is requested by the message hash, the peer likely has its transactions
+                        if (originating_peer->core_protocol_version >= GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION) {
+                            fc::optional<message> compact_block = _message_cache.get_compact_block_message(item_hash);
+                            if (compact_block) {
+                                replies.emplace_back(item_id(block_message_type, *block_id), std::move(compact_block));
+                                auto &compact_blocks_sent = originating_peer->compact_blocks_sent_to_peer;
+                                compact_blocks_sent.push_back(peer_connection::compact_block_sent{*block_id});
+                                if (compact_blocks_sent.size() > GRAPHENE_NET_MAX_COMPACT_BLOCKS_SENT_PER_PEER) {
+                                    compact_blocks_sent.pop_front();
+                                }
+                                last_block_id_sent = *block_id;
+                                continue;
+                            }
+                        }
+                    } else if (_delegate->has_item(item_id(block_message_type, item_hash))) {
+                        dlog("received block request from peer ${endpoint}, returning the block from delegate with id ${id}",
+                                ("id", item_hash)
+                                        ("endpoint", originating_peer->get_remote_endpoint()));
+                        block_id = item_hash;
+                    } else {
+                        replies.emplace_back(item_id(block_message_type, item_hash),
+                                message(item_not_available_message(item_id(block_message_type, item_hash))));
+                        dlog("received item request from peer ${endpoint} but we don't have it",
+                                ("endpoint", originating_peer->get_remote_endpoint()));
+                        continue;
+                    }
+                    replies.emplace_back(item_id(block_message_type, *block_id), fc::optional<message>());
+                    last_block_id_sent = *block_id;
+                }
+
                 // if we sent them a block, update our record of the last block they've seen accordingly
-                if (last_block_message_sent) {
-                    graphene::network::block_message block = last_block_message_sent->as<graphene::network::block_message>();
-                    originating_peer->last_block_delegate_has_seen = block.block_id;
-                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+                if (last_block_id_sent) {
+                    originating_peer->last_block_delegate_has_seen = *last_block_id_sent;
+                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_id_sent);
                 }
 
-                for (const message &reply : reply_messages) {
-                    if (reply.msg_type == block_message_type) {
-                        originating_peer->send_item(item_id(block_message_type, reply.as<graphene::network::block_message>().block_id));
+                for (const auto &reply : replies) {
+                    if (reply.second) {
+                        originating_peer->send_message(*reply.second);
                     } else {
-                        originating_peer->send_message(reply);
+                        originating_peer->send_item(reply.first);
+                    }
+                }
+            }
+
+            void node_impl::on_compact_block_message(peer_connection *originating_peer,
+                    const compact_block_message &compact_block_message_received) {
+                VERIFY_CORRECT_THREAD();
+                // compact blocks are sent only in reply to requests of blocks during normal operation
+                bool block_requested = false;
+                for (const auto &requested_item : originating_peer->items_requested_from_peer) {
+                    if (requested_item.first.item_type == block_message_type) {
+                        block_requested = true;
+                        break;
+                    }
+                }
+                if (!block_requested) {
+                    wlog("received a compact block I didn't ask for from peer ${endpoint}, disconnecting from peer",
+                            ("endpoint", originating_peer->get_remote_endpoint()));
+                    fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a compact block that I didn't ask for"));
+                    disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
+                    return;
+                }
+
+                peer_connection::compact_block_in_progress reconstructed;
+                static_cast<graphene::protocol::signed_block_header &>(reconstructed.block) = compact_block_message_received.header;
+                reconstructed.block_id = compact_block_message_received.header.id();
+                reconstructed.block.transactions.resize(compact_block_message_received.short_ids.size());
+
+                std::unordered_map<uint64_t, uint32_t> unresolved_transactions;
+                for (uint32_t i = 0; i < compact_block_message_received.short_ids.size(); ++i) {
+                    uint64_t short_id = compact_block_message_received.short_ids[i];
+                    fc::optional<signed_transaction> trx = _message_cache.find_transaction(short_id);
+                    if (trx) {
+                        reconstructed.block.transactions[i] = std::move(*trx);
+                    } else {
+                        unresolved_transactions.emplace(short_id, i);
+                    }
+                }
+
+                if (!unresolved_transactions.empty()) {
+                    for (auto &trx : _delegate->get_pending_transactions()) {
+                        auto iter = unresolved_transactions.find(compact_block_message::short_id(trx.id()));
+                        if (iter != unresolved_transactions.end()) {
+                            reconstructed.block.transactions[iter->second] = std::move(trx);
+                            unresolved_transactions.erase(iter);
+                        }
                     }
                 }
+
+                for (uint32_t i = 0; i < compact_block_message_received.short_ids.size(); ++i) {
+                    if (unresolved_transactions.count(compact_block_message_received.short_ids[i])) {
+                        reconstructed.missing_transactions.push_back(i);
+                    }
+                }
+
+                dlog("received compact block ${block_id} with ${count} transactions from peer ${endpoint}, ${missing} are missing",
+                        ("block_id", reconstructed.block_id)
+                                ("count", compact_block_message_received.short_ids.size())
+                                ("missing", reconstructed.missing_transactions.size())
+                                ("endpoint", originating_peer->get_remote_endpoint()));
+
+                originating_peer->compact_block_being_reconstructed = std::move(reconstructed);
+                if (originating_peer->compact_block_being_reconstructed->missing_transactions.empty()) {
+                    process_compact_block(originating_peer);
+                } else {
+                    originating_peer->send_message(get_compact_block_transactions_message(
+                            originating_peer->compact_block_being_reconstructed->block_id,
+                            originating_peer->compact_block_being_reconstructed->missing_transactions));
+                }
+            }
+
+            void node_impl::on_get_compact_block_transactions_message(peer_connection *originating_peer,
+                    const get_compact_block_transactions_message &get_compact_block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const block_id_type &block_id = get_compact_block_transactions_message_received.block_id;
+                const auto &indexes = get_compact_block_transactions_message_received.indexes;
+
+                // transactions are provided only for compact blocks we sent, so a peer can't make us
+                // load arbitrary blocks and send their transactions again and again
+                auto &compact_blocks_sent = originating_peer->compact_blocks_sent_to_peer;
+                auto sent_iter = std::find_if(compact_blocks_sent.begin(), compact_blocks_sent.end(),
+                        [&](const peer_connection::compact_block_sent &sent) { return sent.block_id == block_id; });
+                if (sent_iter == compact_blocks_sent.end() ||
+                        sent_iter->transactions_requests >= GRAPHENE_NET_MAX_COMPACT_BLOCK_TRANSACTIONS_REQUESTS) {
+                    wlog("peer ${endpoint} requested transactions of the block ${block_id} which I didn't send it as a compact block, disconnecting from peer",
+                            ("endpoint", originating_peer->get_remote_endpoint())("block_id", block_id));
+                    fc::exception detailed_error(FC_LOG_MESSAGE(error, "You requested transactions of the block ${block_id} which I didn't send you as a compact block",
+                            ("block_id", block_id)));
+                    disconnect_from_peer(originating_peer, "You requested transactions of a compact block I didn't send you", true, detailed_error);
+                    return;
+                }
+                ++sent_iter->transactions_requests;
+
+                std::vector<signed_transaction> transactions;
+                fc::optional<message> block_message_to_send = _message_cache.get_message_by_contents_hash(block_id);
+                if (block_message_to_send) {
+                    signed_block block = block_message_to_send->as<block_message>().block;
+
+                    // indexes are requested in ascending order, so duplicates are rejected by the same check
+                    bool indexes_valid = indexes.size() <= block.transactions.size();
+                    for (size_t i = 0; indexes_valid && i < indexes.size(); ++i) {
+                        indexes_valid = indexes[i] < block.transactions.size() && (i == 0 || indexes[i - 1] < indexes[i]);
+                    }
+                    if (!indexes_valid) {
+                        wlog("peer ${endpoint} requested invalid transactions of the compact block ${block_id}, disconnecting from peer",
+                                ("endpoint", originating_peer->get_remote_endpoint())("block_id", block_id));
+                        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You requested invalid transactions of the compact block ${block_id}",
+                                ("block_id", block_id)));
+                        disconnect_from_peer(originating_peer, "You requested invalid transactions of a compact block", true, detailed_error);
+                        return;
+                    }
+
+                    transactions.reserve(indexes.size());
+                    for (uint32_t index : indexes) {
+                        transactions.push_back(std::move(block.transactions[index]));
+                    }
+                } else {
+                    // the block left the message cache, the peer fetches it again after the request times out
+                    wlog("peer ${endpoint} requested transactions of the block ${block_id} which I can't provide",
+                            ("endpoint", originating_peer->get_remote_endpoint())("block_id", block_id));
+                }
+                originating_peer->send_message(compact_block_transactions_message(block_id, std::move(transactions)));
+            }
+
+            void node_impl::on_compact_block_transactions_message(peer_connection *originating_peer,
+                    const compact_block_transactions_message &compact_block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                auto &reconstructed = originating_peer->compact_block_being_reconstructed;
+                if (!reconstructed || reconstructed->block_id != compact_block_transactions_message_received.block_id) {
+                    dlog("received transactions of the compact block ${block_id} which I don't reconstruct from peer ${endpoint}",
+                            ("block_id", compact_block_transactions_message_received.block_id)
+                                    ("endpoint", originating_peer->get_remote_endpoint()));
+                    return;
+                }
+
+                const auto &transactions = compact_block_transactions_message_received.transactions;
+                if (transactions.size() != reconstructed->missing_transactions.size()) {
+                    // the request of the block will time out and the block will be fetched again
+                    wlog("peer ${endpoint} didn't provide transactions of the compact block ${block_id}",
+                            ("endpoint", originating_peer->get_remote_endpoint())("block_id", reconstructed->block_id));
+                    reconstructed.reset();
+                    return;
+                }
+
+                for (size_t i = 0; i < transactions.size(); ++i) {
+                    reconstructed->block.transactions[reconstructed->missing_transactions[i]] = transactions[i];
+                }
+                reconstructed->missing_transactions.clear();
+                process_compact_block(originating_peer);
+            }
+
+            void node_impl::process_compact_block(peer_connection *originating_peer) {
+                VERIFY_CORRECT_THREAD();
+                auto &reconstructed = originating_peer->compact_block_being_reconstructed;
+                if (reconstructed->block.calculate_merkle_root() != reconstructed->block.transaction_merkle_root) {
+                    if (!reconstructed->all_transactions_requested) {
+                        // different transactions with the same short ids, so all of them are requested
+                        wlog("reconstructed compact block ${block_id} doesn't match its merkle root, requesting all its transactions from peer ${endpoint}",
+                                ("block_id", reconstructed->block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                        reconstructed->all_transactions_requested = true;
+                        reconstructed->missing_transactions.resize(reconstructed->block.transactions.size());
+                        std::iota(reconstructed->missing_transactions.begin(), reconstructed->missing_transactions.end(), 0);
+                        originating_peer->send_message(get_compact_block_transactions_message(
+                                reconstructed->block_id, reconstructed->missing_transactions));
+                        return;
+                    }
+                    wlog("peer ${endpoint} sent transactions which don't match the compact block ${block_id}, disconnecting from peer",
+                            ("endpoint", originating_peer->get_remote_endpoint())("block_id", reconstructed->block_id));
+                    fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me transactions which don't match the compact block ${block_id}",
+                            ("block_id", reconstructed->block_id)));
+                    reconstructed.reset();
+                    disconnect_from_peer(originating_peer, "You sent me an invalid compact block", true, detailed_error);
+                    return;
+                }
+
+                // the block is handled as if it was received in block_message, it has the same message hash
+                graphene::network::block_message block_message_to_process(std::move(reconstructed->block));
+                reconstructed.reset();
+                message_hash_type message_hash = message(block_message_to_process).id();
+                process_block_message(originating_peer, block_message_to_process, message_hash);
             }
 
             void node_impl::on_item_not_available_message(peer_connection *originating_peer, const item_not_available_message &item_not_available_message_received) {
@@ -3331,54 +3700,59 @@ namespace graphene {
                 std::map<peer_connection_ptr, fc::oexception> peers_with_rejected_block;
 
                 do {
-                    std::copy(std::make_move_iterator(_new_received_sync_items.begin()),
-                            std::make_move_iterator(_new_received_sync_items.end()),
-                            std::front_inserter(_received_sync_items));
-                    _new_received_sync_items.clear();
                     dlog("currently ${count} sync items to consider", ("count", _received_sync_items.size()));
 
                     block_processed_this_iteration = false;
-                    for (auto received_block_iter = _received_sync_items.begin();
-                         received_block_iter != _received_sync_items.end();
-                         ++received_block_iter) {
 
-                        // find out if this block is the next block on the active chain or one of the forks
-                        bool potential_first_block = false;
+                    // the next block on the active chain or one of the forks is the first item to get
+                    //   of a syncing peer, so the received blocks are looked up by peers, not scanned
+                    auto received_block_iter = _received_sync_items.end();
+                    for (const peer_connection_ptr &peer : _active_connections) {
+                        ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+                        if (!peer->ids_of_items_to_get.empty()) {
+                            received_block_iter = _received_sync_items.find(peer->ids_of_items_to_get.front());
+                            if (received_block_iter != _received_sync_items.end()) {
+                                break;
+                            }
+                        }
+                    }
+
+                    if (received_block_iter != _received_sync_items.end()) {
+                        const auto block_id = received_block_iter->first;
+
+                        // remove it from all sync peers lists
                         for (const peer_connection_ptr &peer : _active_connections) {
                             ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
                             if (!peer->ids_of_items_to_get.empty() &&
-                                peer->ids_of_items_to_get.front() ==
-                                received_block_iter->block_id) {
-                                potential_first_block = true;
+                                peer->ids_of_items_to_get.front() == block_id) {
                                 peer->ids_of_items_to_get.pop_front();
-                                peer->ids_of_items_being_processed.insert(received_block_iter->block_id);
+                                peer->ids_of_items_being_processed.insert(block_id);
                             }
                         }
 
-                        // if it is, process it, remove it from all sync peers lists
-                        if (potential_first_block) {
-                            // we can get into an interesting situation near the end of synchronization.  We can be in
-                            // sync with one peer who is sending us the last block on the chain via a regular inventory
-                            // message, while at the same time still be synchronizing with a peer who is sending us the
-                            // block through the sync mechanism.  Further, we must request both blocks because
-                            // we don't know they're the same (for the peer in normal operation, it has only told us the
-                            // message id, for the peer in the sync case we only known the block_id).
-                            if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
-                                    received_block_iter->block_id) ==
-                                _most_recent_blocks_accepted.end()) {
-                                graphene::network::block_message block_message_to_process = *received_block_iter;
-                                _received_sync_items.erase(received_block_iter);
-                                _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
-                                    send_sync_block_to_node_delegate(block_message_to_process);
-                                }, "send_sync_block_to_node_delegate"));
-                                ++blocks_processed;
-                                block_processed_this_iteration = true;
-                            } else
-                                dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
-
-                            break; // start iterating _received_sync_items from the beginning
-                        } // end if potential_first_block
-                    } // end for each block in _received_sync_items
+                        // we can get into an interesting situation near the end of synchronization.  We can be in
+                        // sync with one peer who is sending us the last block on the chain via a regular inventory
+                        // message, while at the same time still be synchronizing with a peer who is sending us the
+                        // block through the sync mechanism.  Further, we must request both blocks because
+                        // we don't know they're the same (for the peer in normal operation, it has only told us the
+                        // message id, for the peer in the sync case we only known the block_id).
+                        if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
+                                block_id) ==
+                            _most_recent_blocks_accepted.end()) {
+                            graphene::network::block_message block_message_to_process = std::move(received_block_iter->second);
+                            _received_sync_items.erase(received_block_iter);
+                            _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
+                                send_sync_block_to_node_delegate(block_message_to_process);
+                            }, "send_sync_block_to_node_delegate"));
+                            ++blocks_processed;
+                            block_processed_this_iteration = true;
+                        } else {
+                            dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+                            _received_sync_items.erase(received_block_iter);
+                            // the next block may be already received too, so look for it again
+                            block_processed_this_iteration = true;
+                        }
+                    } // end if the next block is received
 
                     if (_handle_message_calls_in_progress.size() >=
                         _maximum_number_of_blocks_to_handle_at_one_time) {
@@ -3414,9 +3788,9 @@ namespace graphene {
                 VERIFY_CORRECT_THREAD();
                 dlog("received a sync block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint()));
 
-                // add it to the front of _received_sync_items, then process _received_sync_items to try to
+                // add it to _received_sync_items, then process _received_sync_items to try to
                 // pass as many messages as possible to the client.
-                _new_received_sync_items.push_front(block_message_to_process);
+                _received_sync_items.emplace(block_message_to_process.block_id, block_message_to_process);
                 trigger_process_backlog_of_sync_blocks();
             }
 
@@ -3576,14 +3950,13 @@ namespace graphene {
             }
 
             void node_impl::process_block_message(peer_connection *originating_peer,
-                    const message &message_to_process,
+                    const graphene::network::block_message &block_message_to_process,
                     const message_hash_type &message_hash) {
                 VERIFY_CORRECT_THREAD();
                 // find out whether we requested this item while we were synchronizing or during normal operation
                 // (it's possible that we request an item during normal operation and then get kicked into sync
                 // mode before we receive and process the item.  In that case, we should process the item as a normal
                 // item to avoid confusing the sync code)
-                graphene::network::block_message block_message_to_process(message_to_process.as<graphene::network::block_message>());
                 auto item_iter = originating_peer->items_requested_from_peer.find(item_id(graphene::network::block_message_type, message_hash));
                 if (item_iter !=
                     originating_peer->items_requested_from_peer.end()) {
@@ -4734,7 +5107,6 @@ namespace graphene {
                 ilog("--------- MEMORY USAGE ------------");
                 ilog("node._active_sync_requests size: ${size}", ("size", _active_sync_requests.size()));
                 ilog("node._received_sync_items size: ${size}", ("size", _received_sync_items.size()));
-                ilog("node._new_received_sync_items size: ${size}", ("size", _new_received_sync_items.size()));
                 ilog("node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size()));
                 ilog("node._new_inventory size: ${size}", ("size", _new_inventory.size()));
                 ilog("node._message_cache size: ${size}", ("size", _message_cache.size()));
@@ -4908,9 +5280,15 @@ namespace graphene {
                 fc::uint160_t hash_of_message_contents;
                 if (item_to_broadcast.msg_type ==
                     graphene::network::block_message_type) {
-                    graphene::network::block_message block_message_to_broadcast = item_to_broadcast.as<graphene::network::block_message>();
-                    hash_of_message_contents = block_message_to_broadcast.block_id; // for debugging
-                    _most_recent_blocks_accepted.push_back(block_message_to_broadcast.block_id);
+                    // block_message is the serialized block followed by its id, so the block isn't unpacked
+                    block_id_type block_id;
+                    const size_t block_id_size = fc::raw::pack_size(block_id);
+                    FC_ASSERT(item_to_broadcast.data.size() > block_id_size);
+                    fc::datastream<const char *> block_id_stream(
+                            item_to_broadcast.data.data() + item_to_broadcast.data.size() - block_id_size, block_id_size);
+                    fc::raw::unpack(block_id_stream, block_id);
+                    hash_of_message_contents = block_id; // for debugging
+                    _most_recent_blocks_accepted.push_back(block_id);
                 } else if (item_to_broadcast.msg_type ==
                            graphene::network::trx_message_type) {
                     graphene::network::trx_message transaction_message_to_broadcast = item_to_broadcast.as<graphene::network::trx_message>();
@@ -4979,6 +5357,9 @@ namespace graphene {
                 if (params.contains("maximum_blocks_per_peer_during_syncing")) {
                     _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
                 }
+                if (params.contains("number_of_decode_threads")) {
+                    set_number_of_decode_threads(params["number_of_decode_threads"].as<uint32_t>());
+                }
 
                 _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4999,6 +5380,7 @@ namespace graphene {
                 result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
                 result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
                 result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+                result["number_of_decode_threads"] = uint32_t(_decode_threads.size());
                 return result;
             }
 
@@ -5427,6 +5809,10 @@ namespace graphene {
                 INVOKE_AND_COLLECT_STATISTICS(get_item, id);
             }
 
+            std::vector<signed_transaction> statistics_gathering_node_delegate_wrapper::get_pending_transactions() {
+                INVOKE_AND_COLLECT_STATISTICS(get_pending_transactions);
+            }
+
             std::vector<item_hash_t> statistics_gathering_node_delegate_wrapper::get_blockchain_synopsis(const item_hash_t &reference_point, uint32_t number_of_blocks_after_reference_point) {
                 INVOKE_AND_COLLECT_STATISTICS(get_blockchain_synopsis, reference_point, number_of_blocks_after_reference_point);
             }
@@ -121,8 +121,23 @@ namespace graphene {
             } FC_RETHROW_EXCEPTIONS(warn, "", ("len", len))
         }
 
+/**
+ *   The ciphertext is read directly into the caller's buffer and decrypted
+ *   in place. The socket holds the buffer until the pending read completes,
+ *   so it stays valid even if the read is canceled.
+ */
         size_t stcp_socket::readsome(const std::shared_ptr<char> &buf, size_t len, size_t offset) {
-            return readsome(buf.get() + offset, len);
+            try {
+                assert(len > 0 && (len % 16) == 0);
+
+                size_t s = _sock.readsome(buf, len, offset);
+                if (s % 16) {
+                    _sock.read(buf, 16 - (s % 16), offset + s);
+                    s += 16 - (s % 16);
+                }
+                _recv_aes.decode(buf.get() + offset, s, buf.get() + offset);
+                return s;
+            } FC_RETHROW_EXCEPTIONS(warn, "", ("len", len))
         }
 
         bool stcp_socket::eof() const {
@@ -153,12 +168,11 @@ namespace graphene {
                 } buffer_in_use_checker(_write_buffer_in_use);
 #endif
 
-                const std::size_t write_buffer_length = 4096;
+                const std::size_t write_buffer_length = 64 * 1024;
                 if (!_write_buffer) {
                     _write_buffer.reset(new char[write_buffer_length], [](char *p) { delete[] p; });
                 }
                 len = std::min<size_t>(write_buffer_length, len);
-                memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
                 /**
                  * every sizeof(crypt_buf) bytes the aes channel
                  * has an error and doesn't decrypt properly...  disable
@@ -176,6 +190,15 @@ namespace graphene {
             return writesome(buf.get() + offset, len);
         }
 
+        void stcp_socket::write_in_place(const std::shared_ptr<char> &buf, size_t len) {
+            try {
+                assert((len % 16) == 0);
+                uint32_t ciphertext_len = _send_aes.encode(buf.get(), len, buf.get());
+                assert(ciphertext_len == len);
+                _sock.write(buf, ciphertext_len);
+            } FC_RETHROW_EXCEPTIONS(warn, "", ("len", len))
+        }
+
         void stcp_socket::flush() {
             _sock.flush();
         }
@@ -0,0 +1,416 @@
+#include <graphene/plugins/account_history/history_store.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace graphene { namespace plugins { namespace account_history {
+
+    static void open_file(std::fstream& file, const fc::path& path) {
+        if (!fc::exists(path)) {
+            std::ofstream(path.generic_string(), std::ios::out | std::ios::binary);
+        }
+        file.open(path.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+        FC_ASSERT(file.good(), "Can't open ${p}", ("p", path));
+    }
+
+    static void put_varint(std::vector<char>& data, uint64_t value) {
+        do {
+            char byte = static_cast<char>(value & 0x7f);
+            value >>= 7;
+            if (value) {
+                byte |= 0x80;
+            }
+            data.push_back(byte);
+        } while (value);
+    }
+
+    static uint64_t get_varint(const std::vector<char>& data, std::size_t& pos) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            FC_ASSERT(pos < data.size(), "Account history chunk is truncated");
+            auto byte = static_cast<uint8_t>(data[pos++]);
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        FC_ASSERT(false, "Account history chunk has an invalid varint");
+    }
+
+    account_history_store::~account_history_store() {
+        close();
+    }
+
+    void account_history_store::open(const fc::path& dir) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FC_ASSERT(!_postings.is_open(), "Account history store is already open");
+
+        static_assert(sizeof(account_record) == 16, "account_record shouldn't be padded");
+        static_assert(sizeof(chunk_index_record) == 16, "chunk_index_record shouldn't be padded");
+
+        _dir = dir;
+        if (!fc::exists(dir)) {
+            fc::create_directories(dir);
+        }
+
+        auto names_path = dir / "accounts.names";
+        auto records_path = dir / "accounts.index";
+        auto postings_path = dir / "postings.log";
+        auto chunk_index_path = dir / "chunks.index";
+
+        // names are appended before records, a name of an interrupted append can be left without the record
+        uint64_t names_end = 0;
+        {
+            std::ifstream in(names_path.generic_string(), std::ios::in | std::ios::binary);
+            uint8_t size = 0;
+            char name[256];
+            while (in.read(reinterpret_cast<char*>(&size), 1) && in.read(name, size)) {
+                _account_ids.emplace(account_name_type(std::string(name, size)), _accounts.size());
+                _accounts.emplace_back();
+                names_end += 1 + size;
+            }
+        }
+
+        uint64_t records_size = fc::exists(records_path) ? fc::file_size(records_path) : 0;
+        uint64_t record_count = std::min<uint64_t>(records_size / sizeof(account_record), _accounts.size());
+        if (record_count) {
+            std::ifstream in(records_path.generic_string(), std::ios::in | std::ios::binary);
+            in.read(reinterpret_cast<char*>(_accounts.data()), record_count * sizeof(account_record));
+            FC_ASSERT(in.good(), "Can't read ${p}", ("p", records_path));
+        }
+
+        // chunks are written before records, so a chunk of an interrupted append isn't referred
+        _postings_end = fc::exists(postings_path) ? fc::file_size(postings_path) : 0;
+        for (const auto& record : _accounts) {
+            FC_ASSERT(record.last_pos == UINT64_MAX || record.last_pos < _postings_end,
+                "Account history store is corrupted, remove ${d}", ("d", dir));
+        }
+
+        open_file(_names, names_path);
+        open_file(_records, records_path);
+        open_file(_postings, postings_path);
+
+        _names.close();
+        boost::filesystem::resize_file(names_path.generic_string(), names_end);
+        open_file(_names, names_path);
+
+        for (uint32_t account_id = record_count; account_id < _accounts.size(); ++account_id) {
+            write_record(account_id);
+        }
+
+        _chunks.resize(_accounts.size());
+        if (!load_chunk_index(chunk_index_path)) {
+            rebuild_chunk_index(chunk_index_path);
+        }
+        open_file(_chunk_index, chunk_index_path);
+
+        ilog("Account history store is open, ${a} accounts", ("a", _accounts.size()));
+    }
+
+    void account_history_store::close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_postings.is_open()) {
+            return;
+        }
+
+        _names.close();
+        _records.close();
+        _postings.close();
+        _chunk_index.close();
+
+        _postings_end = 0;
+        _account_ids.clear();
+        _accounts.clear();
+        _chunks.clear();
+    }
+
+    uint32_t account_history_store::get_account_id(const account_name_type& account) {
+        auto itr = _account_ids.find(account);
+        if (itr != _account_ids.end()) {
+            return itr->second;
+        }
+
+        std::string name = account;
+        FC_ASSERT(name.size() < 256);
+
+        uint8_t size = static_cast<uint8_t>(name.size());
+        _names.seekp(0, std::ios::end);
+        _names.write(reinterpret_cast<const char*>(&size), 1);
+        _names.write(name.data(), name.size());
+        _names.flush();
+        FC_ASSERT(_names.good(), "Can't write account history names");
+
+        uint32_t account_id = _accounts.size();
+        _accounts.emplace_back();
+        _chunks.emplace_back();
+        _account_ids.emplace(account, account_id);
+        write_record(account_id);
+        return account_id;
+    }
+
+    void account_history_store::write_record(uint32_t account_id) {
+        _records.seekp(uint64_t(account_id) * sizeof(account_record));
+        _records.write(reinterpret_cast<const char*>(&_accounts[account_id]), sizeof(account_record));
+        _records.flush();
+        FC_ASSERT(_records.good(), "Can't write account history index");
+    }
+
+    void account_history_store::write_chunk_index_record(uint32_t account_id, const chunk_ref& ref) {
+        chunk_index_record index_record;
+        index_record.account_id = account_id;
+        index_record.first_sequence = ref.first_sequence;
+        index_record.pos = ref.pos;
+
+        _chunk_index.seekp(0, std::ios::end);
+        _chunk_index.write(reinterpret_cast<const char*>(&index_record), sizeof(index_record));
+        _chunk_index.flush();
+        FC_ASSERT(_chunk_index.good(), "Can't write account history chunk index");
+    }
+
+    bool account_history_store::load_chunk_index(const fc::path& path) {
+        if (!fc::exists(path)) {
+            return _postings_end == 0;
+        }
+
+        // records are written after chunks and before records of accounts,
+        //   so only the last record can refer to a chunk of an interrupted append
+        uint64_t valid_size = 0;
+        {
+            std::ifstream in(path.generic_string(), std::ios::in | std::ios::binary);
+            chunk_index_record index_record;
+            while (in.read(reinterpret_cast<char*>(&index_record), sizeof(index_record))) {
+                if (index_record.account_id >= _accounts.size()) {
+                    break;
+                }
+                const auto& record = _accounts[index_record.account_id];
+                if (record.last_pos == UINT64_MAX || index_record.pos > record.last_pos) {
+                    break;
+                }
+                auto& chunks = _chunks[index_record.account_id];
+                if (!chunks.empty() && chunks.back().first_sequence >= index_record.first_sequence) {
+                    return false;
+                }
+                chunks.push_back(chunk_ref{index_record.first_sequence, index_record.pos});
+                valid_size += sizeof(index_record);
+            }
+        }
+        boost::filesystem::resize_file(path.generic_string(), valid_size);
+
+        for (uint32_t account_id = 0; account_id < _accounts.size(); ++account_id) {
+            const auto& chunks = _chunks[account_id];
+            const auto last_pos = chunks.empty() ? UINT64_MAX : chunks.back().pos;
+            if (last_pos != _accounts[account_id].last_pos) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void account_history_store::rebuild_chunk_index(const fc::path& path) {
+        wlog("Rebuilding account history chunk index...");
+
+        std::ofstream out(path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        for (uint32_t account_id = 0; account_id < _accounts.size(); ++account_id) {
+            auto& chunks = _chunks[account_id];
+            chunks.clear();
+            for (auto pos = _accounts[account_id].last_pos; pos != UINT64_MAX;) {
+                auto header = read_chunk_header(pos);
+                chunks.push_back(chunk_ref{header.first_sequence, pos});
+                pos = header.prev_pos;
+            }
+            std::reverse(chunks.begin(), chunks.end());
+
+            for (const auto& ref : chunks) {
+                chunk_index_record index_record;
+                index_record.account_id = account_id;
+                index_record.first_sequence = ref.first_sequence;
+                index_record.pos = ref.pos;
+                out.write(reinterpret_cast<const char*>(&index_record), sizeof(index_record));
+            }
+        }
+        out.close();
+        FC_ASSERT(out.good(), "Can't write ${p}", ("p", path));
+    }
+
+    void account_history_store::append(
+        const account_name_type& account, const std::vector<account_history_entry>& entries
+    ) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FC_ASSERT(_postings.is_open(), "Account history store isn't open");
+
+        if (entries.empty()) {
+            return;
+        }
+
+        auto account_id = get_account_id(account);
+        auto& record = _accounts[account_id];
+
+        // blocks up to the last irreversible block are applied again on replay
+        uint32_t first_sequence = entries.front().sequence;
+        std::size_t skip = 0;
+        if (record.last_pos != UINT64_MAX) {
+            if (first_sequence + entries.size() <= record.end_sequence) {
+                return;
+            }
+            skip = std::max(first_sequence, record.end_sequence) - first_sequence;
+            FC_ASSERT(first_sequence + skip == record.end_sequence,
+                "Account history of ${a} has a gap between ${e} and ${s}",
+                ("a", account)("e", record.end_sequence)("s", first_sequence));
+        }
+
+        std::vector<char> data(sizeof(uint32_t) + sizeof(uint64_t));
+        std::memcpy(data.data() + sizeof(uint32_t), &record.last_pos, sizeof(uint64_t));
+        put_varint(data, account_id);
+        put_varint(data, first_sequence + skip);
+        put_varint(data, entries.size() - skip);
+        uint64_t prev_op = 0;
+        for (auto i = skip; i < entries.size(); ++i) {
+            // ids of operations grow with sequences
+            FC_ASSERT(entries[i].sequence == first_sequence + i && entries[i].op >= prev_op);
+            put_varint(data, entries[i].op - prev_op);
+            put_varint(data, entries[i].op_type);
+            prev_op = entries[i].op;
+        }
+        uint32_t size = data.size() - sizeof(uint32_t);
+        std::memcpy(data.data(), &size, sizeof(uint32_t));
+
+        _postings.seekp(_postings_end);
+        _postings.write(data.data(), data.size());
+        _postings.flush();
+        FC_ASSERT(_postings.good(), "Can't write account history postings");
+
+        chunk_ref ref{first_sequence + static_cast<uint32_t>(skip), _postings_end};
+        write_chunk_index_record(account_id, ref);
+        _chunks[account_id].push_back(ref);
+
+        if (record.last_pos == UINT64_MAX) {
+            record.first_sequence = first_sequence;
+        }
+        record.last_pos = _postings_end;
+        record.end_sequence = first_sequence + entries.size();
+        _postings_end += data.size();
+        write_record(account_id);
+    }
+
+    account_history_store::chunk account_history_store::read_chunk(uint64_t pos) const {
+        uint32_t size = 0;
+        _postings.seekg(pos);
+        _postings.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+        std::vector<char> data(size);
+        _postings.read(data.data(), data.size());
+        FC_ASSERT(_postings.good(), "Can't read account history postings");
+
+        chunk result;
+        std::memcpy(&result.prev_pos, data.data(), sizeof(uint64_t));
+
+        std::size_t data_pos = sizeof(uint64_t);
+        get_varint(data, data_pos); // account id
+        result.first_sequence = static_cast<uint32_t>(get_varint(data, data_pos));
+        auto count = get_varint(data, data_pos);
+
+        result.entries.resize(count);
+        uint64_t op = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            auto& entry = result.entries[i];
+            op += get_varint(data, data_pos);
+            entry.sequence = result.first_sequence + i;
+            entry.op = op;
+            entry.op_type = static_cast<uint16_t>(get_varint(data, data_pos));
+        }
+        return result;
+    }
+
+    account_history_store::chunk account_history_store::read_chunk_header(uint64_t pos) const {
+        uint32_t size = 0;
+        _postings.seekg(pos);
+        _postings.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+        // the position and two varints of up to 5 bytes
+        std::vector<char> data(std::min<uint32_t>(size, sizeof(uint64_t) + 10));
+        _postings.read(data.data(), data.size());
+        FC_ASSERT(_postings.good() && data.size() >= sizeof(uint64_t), "Can't read account history postings");
+
+        chunk result;
+        std::memcpy(&result.prev_pos, data.data(), sizeof(uint64_t));
+
+        std::size_t data_pos = sizeof(uint64_t);
+        get_varint(data, data_pos); // account id
+        result.first_sequence = static_cast<uint32_t>(get_varint(data, data_pos));
+        return result;
+    }
+
+    std::vector<account_history_entry> account_history_store::find_entries(
+        const account_name_type& account,
+        uint32_t from,
+        uint32_t limit,
+        bool ascending,
+        const fc::flat_set<uint16_t>& op_types,
+        uint32_t max_scanned
+    ) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<account_history_entry> result;
+        auto itr = _account_ids.find(account);
+        if (itr == _account_ids.end() || limit == 0 || max_scanned == 0) {
+            return result;
+        }
+
+        const auto& record = _accounts[itr->second];
+        if (record.last_pos == UINT64_MAX) {
+            return result;
+        }
+
+        auto add_entry = [&](const account_history_entry& entry) {
+            if (op_types.empty() || op_types.count(entry.op_type)) {
+                result.push_back(entry);
+            }
+            return result.size() < limit;
+        };
+
+        // the chunk after the chunk which contains from
+        const auto& chunks = _chunks[itr->second];
+        auto from_chunk = std::upper_bound(chunks.begin(), chunks.end(), from,
+            [](uint32_t sequence, const chunk_ref& ref) { return sequence < ref.first_sequence; });
+
+        if (!ascending) {
+            uint32_t window_begin = from >= max_scanned ? from - max_scanned + 1 : 0;
+            for (auto chunk_itr = from_chunk; chunk_itr != chunks.begin();) {
+                --chunk_itr;
+                auto item = read_chunk(chunk_itr->pos);
+                for (auto entry = item.entries.rbegin(); entry != item.entries.rend(); ++entry) {
+                    if (entry->sequence > from) {
+                        continue;
+                    }
+                    if (entry->sequence < window_begin || !add_entry(*entry)) {
+                        return result;
+                    }
+                }
+            }
+            return result;
+        }
+
+        uint32_t window_end = from <= UINT32_MAX - (max_scanned - 1) ? from + (max_scanned - 1) : UINT32_MAX;
+
+        if (from_chunk != chunks.begin()) {
+            --from_chunk;
+        }
+        for (auto chunk_itr = from_chunk; chunk_itr != chunks.end() && chunk_itr->first_sequence <= window_end; ++chunk_itr) {
+            auto item = read_chunk(chunk_itr->pos);
+            for (const auto& entry : item.entries) {
+                if (entry.sequence < from) {
+                    continue;
+                }
+                if (entry.sequence > window_end || !add_entry(entry)) {
+                    return result;
+                }
+            }
+        }
+        return result;
+    }
+
+} } } // graphene::plugins::account_history
@@ -33,7 +33,8 @@ namespace graphene { namespace plugins { namespace account_history {
 
     enum account_object_types {
         account_history_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8),
-        account_range_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8) +1
+        account_range_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8) +1,
+        account_operation_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8) +2
     };
 
     using namespace graphene::chain;
@@ -108,8 +109,60 @@ namespace graphene { namespace plugins { namespace account_history {
                 composite_key_compare<std::less<account_name_type>, std::greater<uint32_t>>>>,
         allocator<account_history_object>>;
 
+    /**
+     * Type of the operation of an account_history_object, it's created only if history-operation-type-index is enabled
+     */
+    class account_operation_object final: public object<account_operation_object_type, account_operation_object> {
+    public:
+        template <typename Constructor, typename Allocator>
+        account_operation_object(Constructor &&c, allocator <Allocator> a) {
+            c(*this);
+        }
+
+        id_type id;
+
+        account_name_type account;
+        uint32_t sequence = 0;
+        uint16_t op_type = 0;
+        operation_id_type op;
+    };
+
+    using account_operation_id_type = object_id<account_operation_object>;
+
+    struct by_account_operation;
+    using account_operation_index = multi_index_container<
+        account_operation_object,
+        indexed_by<
+            ordered_unique<
+                tag<by_id>,
+                member<account_operation_object, account_operation_id_type, &account_operation_object::id>>,
+            ordered_unique<tag<by_account>,
+                composite_key<account_operation_object,
+                    member<account_operation_object, account_name_type, &account_operation_object::account>,
+                    member<account_operation_object, uint32_t, &account_operation_object::sequence>>,
+                composite_key_compare<std::less<account_name_type>, std::greater<uint32_t>>>,
+            ordered_unique<tag<by_account_operation>,
+                composite_key<account_operation_object,
+                    member<account_operation_object, account_name_type, &account_operation_object::account>,
+                    member<account_operation_object, uint16_t, &account_operation_object::op_type>,
+                    member<account_operation_object, uint32_t, &account_operation_object::sequence>>,
+                composite_key_compare<std::less<account_name_type>, std::less<uint16_t>, std::greater<uint32_t>>>>,
+        allocator<account_operation_object>>;
+
 } } } // graphene::plugins::account_history
 
+FC_REFLECT(
+    (graphene::plugins::account_history::account_range_object),
+    (id)(account)(start_sequence)(end_sequence))
+
+FC_REFLECT(
+    (graphene::plugins::account_history::account_history_object),
+    (id)(account)(block)(sequence)(op))
+
+FC_REFLECT(
+    (graphene::plugins::account_history::account_operation_object),
+    (id)(account)(sequence)(op_type)(op))
+
 CHAINBASE_SET_INDEX_TYPE(
     graphene::plugins::account_history::account_range_object,
     graphene::plugins::account_history::account_range_index)
@@ -117,3 +170,7 @@ CHAINBASE_SET_INDEX_TYPE(
 CHAINBASE_SET_INDEX_TYPE(
     graphene::plugins::account_history::account_history_object,
     graphene::plugins::account_history::account_history_index)
+
+CHAINBASE_SET_INDEX_TYPE(
+    graphene::plugins::account_history::account_operation_object,
+    graphene::plugins::account_history::account_operation_index)
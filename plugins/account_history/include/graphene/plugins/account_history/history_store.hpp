@@ -0,0 +1,130 @@
+#pragma once
+
+#include <graphene/protocol/types.hpp>
+
+#include <fc/container/flat.hpp>
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace account_history {
+
+    using graphene::protocol::account_name_type;
+
+    struct account_history_entry final {
+        uint32_t sequence = 0;
+        uint64_t op = 0;
+        uint16_t op_type = 0;
+    };
+
+    /**
+     * Append-only store of account history entries of irreversible blocks.
+     *
+     * Account names are interned to integer ids: accounts.names contains names in the order of ids,
+     * and accounts.index contains a record per id (the position of the last chunk of the account,
+     * the first stored sequence and the sequence following the last stored one).
+     *
+     * postings.log contains chunks of consecutive entries of an account:
+     *
+     * +------+-------------------+------------+----------------+-------+----------------------------+-----+
+     * | Size | Pos of prev chunk | Account id | First sequence | Count | Op id delta, Op type (1st) | ... |
+     * +------+-------------------+------------+----------------+-------+----------------------------+-----+
+     *
+     * All fields after the position are varints, the delta of the first entry is the op id itself.
+     * Types of operations are filtered without reading of operations.
+     *
+     * chunks.index contains a record per chunk (the account id, the first sequence and the position of the chunk),
+     * it's loaded on open into per-account arrays of chunks ordered by sequences, so a query finds the chunk
+     * of its first sequence by binary search. If the file is missing, it's rebuilt from the backward links of chunks.
+     *
+     * Appending is called under the write lock of the database, reading is called under the read lock.
+     */
+    class account_history_store final {
+    public:
+        account_history_store() = default;
+
+        ~account_history_store();
+
+        void open(const fc::path& dir);
+
+        void close();
+
+        /**
+         * Appends entries with consecutive sequences, entries which are already stored are ignored
+         */
+        void append(const account_name_type& account, const std::vector<account_history_entry>& entries);
+
+        /**
+         * Returns up to limit stored entries of the account, starting from the sequence from
+         * in descending or ascending order. If op_types isn't empty, only entries with these types are returned.
+         * The scan stops after max_scanned sequences from the sequence from.
+         */
+        std::vector<account_history_entry> find_entries(
+            const account_name_type& account,
+            uint32_t from,
+            uint32_t limit,
+            bool ascending,
+            const fc::flat_set<uint16_t>& op_types,
+            uint32_t max_scanned) const;
+
+    private:
+        struct account_record {
+            uint64_t last_pos = UINT64_MAX;
+            uint32_t first_sequence = 0;
+            uint32_t end_sequence = 0;
+        };
+
+        struct chunk_index_record {
+            uint32_t account_id = 0;
+            uint32_t first_sequence = 0;
+            uint64_t pos = 0;
+        };
+
+        struct chunk_ref {
+            uint32_t first_sequence = 0;
+            uint64_t pos = 0;
+        };
+
+        struct chunk {
+            uint64_t prev_pos = UINT64_MAX;
+            uint32_t first_sequence = 0;
+            std::vector<account_history_entry> entries;
+        };
+
+        uint32_t get_account_id(const account_name_type& account);
+
+        void write_record(uint32_t account_id);
+
+        void write_chunk_index_record(uint32_t account_id, const chunk_ref& ref);
+
+        /**
+         * Loads chunks.index, returns false if it doesn't match records of accounts
+         */
+        bool load_chunk_index(const fc::path& path);
+
+        void rebuild_chunk_index(const fc::path& path);
+
+        chunk read_chunk(uint64_t pos) const;
+
+        /**
+         * Reads only the position of the previous chunk and the first sequence
+         */
+        chunk read_chunk_header(uint64_t pos) const;
+
+        fc::path _dir;
+        mutable std::fstream _names;
+        mutable std::fstream _records;
+        mutable std::fstream _postings;
+        std::fstream _chunk_index;
+        mutable std::mutex _mutex;
+
+        uint64_t _postings_end = 0;
+        std::map<account_name_type, uint32_t> _account_ids;
+        std::vector<account_record> _accounts;
+        std::vector<std::vector<chunk_ref>> _chunks; // chunks of each account in the order of sequences
+    };
+
+} } } // graphene::plugins::account_history
@@ -87,6 +87,14 @@ namespace graphene { namespace plugins { namespace account_history {
              *
              *  @param from - the absolute sequence number, -1 means most recent, limit is the number of operations before from.
              *  @param limit - the maximum number of items that can be queried (0 to 1000], must be less than from
+             *
+             *  With optional arguments, the method returns up to limit operations starting from the sequence from:
+             *  @param op_types - names or numbers of operation types to return, all types if it's empty,
+             *                   filtering requires the history-operation-type-index option
+             *  @param ascending - the direction from the sequence from, the default is descending
+             *
+             *  The form with optional arguments scans up to 10000 sequences from the sequence from. If fewer than limit
+             *  operations are found, the next call continues from the sequence after the scanned ones.
              */
             (get_account_history)
         )
@@ -1,9 +1,11 @@
 #include <graphene/plugins/account_history/plugin.hpp>
 #include <graphene/plugins/account_history/history_object.hpp>
+#include <graphene/plugins/account_history/history_store.hpp>
 
 #include <graphene/plugins/operation_history/history_object.hpp>
 
 #include <graphene/chain/operation_notification.hpp>
+#include <graphene/protocol/operation_util_impl.hpp>
 
 #include <boost/algorithm/string.hpp>
 #define NAMESPACE_PREFIX "graphene::protocol::"
@@ -36,10 +38,12 @@ if( options.count(name) ) { \
         operation_visitor(
             graphene::chain::database& db,
             const graphene::chain::operation_notification& op_note,
-            std::string op_account)
+            std::string op_account,
+            bool index_types)
             : database(db),
               note(op_note),
-              account(op_account){
+              account(op_account),
+              index_operation_types(index_types){
         }
 
         using result_type = void;
@@ -47,15 +51,16 @@ if( options.count(name) ) { \
         graphene::chain::database& database;
         const graphene::chain::operation_notification& note;
         std::string account;
+        bool index_operation_types;
 
         template<typename Op>
         void operator()(Op &&) const {
-            const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
-
-            auto itr = idx.lower_bound(std::make_tuple(account, uint32_t(-1)));
+            // the range follows the last entry of the account, entries can be moved to the disk store
+            const auto& idx_range = database.get_index<account_range_index>().indices().get<range_by_account>();
+            auto itr_range = idx_range.find(account);
             uint32_t sequence = 0;
-            if (itr != idx.end() && itr->account == account) {
-                sequence = itr->sequence + 1;
+            if (itr_range != idx_range.end()) {
+                sequence = itr_range->end_sequence + 1;
             }
 
             database.create<account_history_object>([&](account_history_object& history) {
@@ -65,8 +70,15 @@ if( options.count(name) ) { \
                 history.op = operation_history::operation_id_type(note.db_id);
             });
 
-            const auto& idx_range = database.get_index<account_range_index>().indices().get<range_by_account>();
-            auto itr_range = idx_range.find(account);
+            if (index_operation_types) {
+                database.create<account_operation_object>([&](account_operation_object& item) {
+                    item.account = account;
+                    item.sequence = sequence;
+                    item.op_type = static_cast<uint16_t>(note.op.which());
+                    item.op = operation_history::operation_id_type(note.db_id);
+                });
+            }
+
             if(itr_range == idx_range.end()){
                 database.create<account_range_object>([&](account_range_object& range) {
                     range.account = account;
@@ -90,39 +102,154 @@ if( options.count(name) ) { \
 
         ~plugin_impl() = default;
 
+        // purging runs once per purge_interval blocks and removes whole blocks up to purge_limit entries,
+        //   the rest is removed on next blocks
         void purge_old_history(){
             uint32_t head_block = database.head_block_num();
-            //ilog("account_history: purge_old_history START ${c} <= ${h}", ("c",history_count_blocks)("h", head_block));
-            if (history_count_blocks <= head_block) {
-                uint32_t need_block = head_block - history_count_blocks;
-                const auto& idx = database.get_index<account_history_index>().indices().get<by_block>();
-                auto it = idx.begin();
-                while (it != idx.end() && it->block <= need_block) {
-                    //change account range object if needed
-                    const auto& idx_range = database.get_index<account_range_index>().indices().get<range_by_account>();
-                    auto itr_range = idx_range.find(it->account);
-                    if(itr_range != idx_range.end()){
-                        if(itr_range->start_sequence <= it->sequence){
-                            //remove account range object if it have one sequence in range
-                            if(itr_range->start_sequence == itr_range->end_sequence){
-                                database.remove(*itr_range);
-                            }
-                            else{
-                                //edit start sequence
-                                database.modify(*itr_range, [&](account_range_object& range) {
-                                    range.start_sequence++;
-                                });
-                            }
-                        }
-                    }
+            if (history_count_blocks > head_block) {
+                return;
+            }
+            if (!purge_pending && head_block < last_purge_block + purge_interval) {
+                return;
+            }
+            last_purge_block = head_block;
+
+            auto start = fc::time_point::now();
+            uint32_t need_block = head_block - history_count_blocks;
+            const auto& idx = database.get_index<account_history_index>().indices().get<by_block>();
+            auto it = idx.begin();
+            uint32_t count = 0;
+            uint32_t last_block = 0;
+
+            // the last removed sequence of each account, ranges are changed once per account
+            fc::flat_map<graphene::chain::account_name_type, uint32_t> removed;
+            while (it != idx.end() && it->block <= need_block && (count < purge_limit || it->block == last_block)) {
+                auto& sequence = removed[it->account];
+                sequence = std::max(sequence, it->sequence);
+
+                auto next_it = it;
+                ++next_it;
+                last_block = it->block;
+                remove_history_object(*it);
+                ++count;
+                it = next_it;
+            }
+            purge_pending = (it != idx.end() && it->block <= need_block);
+
+            const auto& idx_range = database.get_index<account_range_index>().indices().get<range_by_account>();
+            for (const auto& item : removed) {
+                auto itr_range = idx_range.find(item.first);
+                if (itr_range == idx_range.end() || itr_range->start_sequence > item.second) {
+                    continue;
+                }
+                if (itr_range->end_sequence <= item.second) {
+                    //remove account range object if all its sequences are removed
+                    database.remove(*itr_range);
+                } else {
+                    //edit start sequence
+                    database.modify(*itr_range, [&](account_range_object& range) {
+                        range.start_sequence = item.second + 1;
+                    });
+                }
+            }
+
+            if (count) {
+                auto elapsed = (fc::time_point::now() - start).count() / 1000;
+                if (elapsed >= 50) {
+                    wlog("account_history: purge of ${c} entries of ${a} accounts up to block ${b} took ${t} ms",
+                        ("c", count)("a", removed.size())("b", last_block)("t", elapsed));
+                } else {
+                    dlog("account_history: purge of ${c} entries of ${a} accounts up to block ${b} took ${t} ms",
+                        ("c", count)("a", removed.size())("b", last_block)("t", elapsed));
+                }
+            }
+        }
+
+        // entries of irreversible blocks are moved from the shared memory to the disk store by chunks,
+        //   entries of accounts, which don't fill a chunk, are moved once per day
+        void move_irreversible_history() {
+            uint32_t last_irreversible_block = database.last_non_undoable_block_num();
+            if (last_irreversible_block <= last_moved_block) {
+                return;
+            }
+
+            bool move_all = last_irreversible_block >= last_moved_all_block + CHAIN_BLOCKS_PER_DAY;
+
+            const auto& idx = database.get_index<account_history_index>().indices().get<by_block>();
+            auto itr = move_all ? idx.begin() : idx.upper_bound(last_moved_block);
+
+            fc::flat_set<graphene::chain::account_name_type> accounts;
+            for (; itr != idx.end() && itr->block <= last_irreversible_block; ++itr) {
+                accounts.insert(itr->account);
+            }
+
+            for (const auto& account : accounts) {
+                move_account_history(account, last_irreversible_block, move_all ? 1 : chunk_entries);
+            }
+
+            last_moved_block = last_irreversible_block;
+            if (move_all) {
+                last_moved_all_block = last_irreversible_block;
+            }
+        }
+
+        void move_account_history(
+            const graphene::chain::account_name_type& account,
+            uint32_t last_irreversible_block,
+            uint32_t min_entries
+        ) {
+            const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
 
-                    auto next_it = it;
-                    ++next_it;
-                    //ilog("account_history: REMOVE ${c}", ("c",it->block));
-                    database.remove(*it);
-                    it = next_it;
+            // sequences are in descending order, so entries of irreversible blocks are at the end of the account
+            auto begin = idx.lower_bound(std::make_tuple(account));
+            auto itr = idx.upper_bound(std::make_tuple(account));
+
+            std::vector<const account_history_object*> objects;
+            while (itr != begin) {
+                --itr;
+                if (itr->block > last_irreversible_block) {
+                    break;
                 }
+                objects.push_back(&*itr);
+            }
+
+            if (objects.empty() || objects.size() < min_entries) {
+                return;
+            }
+
+            std::vector<account_history_entry> entries;
+            entries.reserve(objects.size());
+            for (auto obj : objects) {
+                entries.push_back(account_history_entry{obj->sequence, static_cast<uint64_t>(obj->op._id), find_operation_type(*obj)});
+            }
+
+            store.append(account, entries);
+            for (auto obj : objects) {
+                remove_history_object(*obj);
+            }
+        }
+
+        const account_operation_object* find_operation_object(const account_history_object& obj) const {
+            if (!index_operation_types) {
+                return nullptr;
+            }
+            const auto& idx = database.get_index<account_operation_index>().indices().get<by_account>();
+            auto itr = idx.find(std::make_tuple(obj.account, obj.sequence));
+            return itr != idx.end() ? &*itr : nullptr;
+        }
+
+        /// the type is known only with history-operation-type-index, the disk store keeps 0 without it
+        uint16_t find_operation_type(const account_history_object& obj) const {
+            auto item = find_operation_object(obj);
+            return item ? item->op_type : 0;
+        }
+
+        void remove_history_object(const account_history_object& obj) {
+            auto item = find_operation_object(obj);
+            if (item) {
+                database.remove(*item);
             }
+            database.remove(obj);
         }
 
         void on_operation(const graphene::chain::operation_notification& note) {
@@ -135,12 +262,12 @@ if( options.count(name) ) { \
 
             for (const auto& item : impacted) {
                 if (0 == tracked_accounts.size()) {
-                    note.op.visit(operation_visitor(database, note, item));
+                    note.op.visit(operation_visitor(database, note, item, index_operation_types));
                 }
                 else{
                     auto itr = tracked_accounts.lower_bound(item);
                     if (itr != tracked_accounts.end() && itr->first <= item && item <= itr->second) {
-                        note.op.visit(operation_visitor(database, note, item));
+                        note.op.visit(operation_visitor(database, note, item, index_operation_types));
                     }
                 }
             }
@@ -164,32 +291,194 @@ if( options.count(name) ) { \
             FC_ASSERT(limit <= 1000, "Limit of ${l} is greater than maxmimum allowed (1000)", ("l", limit));
             FC_ASSERT(from >= limit, "From must be greater than limit");
             //   idump((account)(from)(limit));
+            if (store_to_disk) {
+                // entries of the range [from-limit, from] are found in the shared memory and in the disk store
+                uint32_t high = std::min(from, itr_range->end_sequence);
+                uint32_t low = high > limit ? high - limit : 0;
+                return find_account_history(account, high, high - low + 1, false, {});
+            }
+
             const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
             auto itr = idx.lower_bound(std::make_tuple(account, from));
             //   if( itr != idx.end() ) idump((*itr));
             auto end = idx.upper_bound(std::make_tuple(account, std::max(int64_t(0), int64_t(itr->sequence) - limit)));
             //   if( end != idx.end() ) idump((*end));
 
+            // operations of irreversible blocks can be moved to the disk store of operation_history
+            auto& history_plugin = appbase::app().get_plugin<operation_history::plugin>();
+
             std::map<uint32_t, applied_operation> result;
             for (; itr != end; ++itr) {
-                result[itr->sequence] = database.get(itr->op);
+                result[itr->sequence] = history_plugin.get_operation(itr->op);
+            }
+            return result;
+        }
+
+        template<typename Index, typename FromKey, typename EndKey>
+        static void find_entries(
+            const Index& idx,
+            const FromKey& from_key,
+            const EndKey& end_key,
+            uint32_t limit,
+            bool ascending,
+            std::vector<account_history_entry>& result
+        ) {
+            // sequences are in descending order, end_key is the other bound of the scanned sequences
+            if (!ascending) {
+                auto itr = idx.lower_bound(from_key);
+                auto end = idx.upper_bound(end_key);
+                for (uint32_t count = 0; itr != end && count < limit; ++itr, ++count) {
+                    result.push_back(account_history_entry{itr->sequence, static_cast<uint64_t>(itr->op._id)});
+                }
+            } else {
+                auto begin = idx.lower_bound(end_key);
+                auto itr = idx.upper_bound(from_key);
+                for (uint32_t count = 0; itr != begin && count < limit; ++count) {
+                    --itr;
+                    result.push_back(account_history_entry{itr->sequence, static_cast<uint64_t>(itr->op._id)});
+                }
+            }
+        }
+
+        /**
+         * Finds up to limit entries starting from the sequence from, types of operations are checked
+         * before operations are read. Only max_scanned_entries sequences from the sequence from are scanned.
+         */
+        std::map<uint32_t, applied_operation> find_account_history(
+            const std::string& account,
+            uint32_t from,
+            uint32_t limit,
+            bool ascending,
+            const fc::flat_set<uint16_t>& op_types
+        ) {
+            uint32_t end = ascending
+                ? (from <= UINT32_MAX - (max_scanned_entries - 1) ? from + (max_scanned_entries - 1) : UINT32_MAX)
+                : (from >= max_scanned_entries ? from - max_scanned_entries + 1 : 0);
+
+            std::vector<account_history_entry> entries;
+            if (op_types.empty()) {
+                const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
+                find_entries(
+                    idx, std::make_tuple(account, from), std::make_tuple(account, end),
+                    limit, ascending, entries);
+            } else {
+                const auto& idx = database.get_index<account_operation_index>().indices().get<by_account_operation>();
+                for (auto op_type : op_types) {
+                    find_entries(
+                        idx, std::make_tuple(account, op_type, from), std::make_tuple(account, op_type, end),
+                        limit, ascending, entries);
+                }
+            }
+
+            // older entries are in the disk store
+            if (store_to_disk) {
+                auto stored = store.find_entries(account, from, limit, ascending, op_types, max_scanned_entries);
+                entries.insert(entries.end(), stored.begin(), stored.end());
+            }
+
+            std::sort(entries.begin(), entries.end(), [&](const account_history_entry& a, const account_history_entry& b) {
+                return ascending ? a.sequence < b.sequence : a.sequence > b.sequence;
+            });
+
+            auto& history_plugin = appbase::app().get_plugin<operation_history::plugin>();
+
+            std::map<uint32_t, applied_operation> result;
+            for (const auto& entry : entries) {
+                if (result.size() >= limit) {
+                    break;
+                }
+                if (!result.count(entry.sequence)) {
+                    result[entry.sequence] = history_plugin.get_operation(operation_id_type(entry.op));
+                }
             }
             return result;
         }
 
+        std::map<uint32_t, applied_operation> get_filtered_account_history(
+            const std::string& account,
+            uint32_t from,
+            uint32_t limit,
+            const std::vector<fc::variant>& op_names,
+            bool ascending
+        ) {
+            const auto& idx_range = database.get_index<account_range_index>().indices().get<range_by_account>();
+            FC_ASSERT(idx_range.find(account) != idx_range.end(),
+                "Account not found in history index, it may have been purged since the last  ${b} blocks are stored in the history",
+                ("b", history_count_blocks));
+            FC_ASSERT(limit <= 1000, "Limit of ${l} is greater than maxmimum allowed (1000)", ("l", limit));
+            FC_ASSERT(op_names.empty() || index_operation_types,
+                "Filtering by operation types is disabled, enable history-operation-type-index");
+
+            fc::flat_set<uint16_t> op_types;
+            for (const auto& name : op_names) {
+                op_types.insert(get_operation_type(name));
+            }
+            if (!ascending) {
+                // -1 means the most recent operation
+                from = std::min(from, idx_range.find(account)->end_sequence);
+            }
+            return find_account_history(account, from, limit, ascending, op_types);
+        }
+
+        static uint16_t get_operation_type(const fc::variant& name) {
+            static const std::map<std::string, uint16_t> types = []() {
+                std::map<std::string, uint16_t> result;
+                for (int i = 0; i < operation::count(); ++i) {
+                    operation op;
+                    op.set_which(i);
+                    std::string op_name;
+                    op.visit(fc::get_operation_name(op_name));
+                    result[op_name] = static_cast<uint16_t>(i);
+                    result[op_name + "_operation"] = static_cast<uint16_t>(i);
+                }
+                return result;
+            }();
+
+            if (name.is_uint64()) {
+                FC_ASSERT(name.as_uint64() < uint64_t(operation::count()), "Invalid operation type ${t}", ("t", name));
+                return static_cast<uint16_t>(name.as_uint64());
+            }
+            auto itr = types.find(name.as_string());
+            FC_ASSERT(itr != types.end(), "Invalid operation name ${n}", ("n", name));
+            return itr->second;
+        }
+
+        static constexpr uint32_t chunk_entries = 64;
+
+        /// the number of sequences scanned by a filtered query, it bounds the work of a call
+        static constexpr uint32_t max_scanned_entries = 10000;
+
         fc::flat_map<std::string, std::string> tracked_accounts;
         graphene::chain::database& database;
         uint32_t history_count_blocks = UINT32_MAX;
+        uint32_t purge_interval = 1;
+        uint32_t purge_limit = UINT32_MAX;
+        uint32_t last_purge_block = 0;
+        bool purge_pending = false;
+        bool store_to_disk = false;
+        bool index_operation_types = false;
+        account_history_store store;
+        uint32_t last_moved_block = 0;
+        uint32_t last_moved_all_block = 0;
     };
 
     DEFINE_API(plugin, get_account_history) {
-        CHECK_ARG_SIZE(3)
+        auto n_args = args.args->size();
+        FC_ASSERT(n_args >= 3 && n_args <= 5, "Expected 3-5 arguments, was ${n}", ("n", n_args));
         auto account = args.args->at(0).as<std::string>();
         auto from = args.args->at(1).as<uint32_t>();
         auto limit = args.args->at(2).as<uint32_t>();
 
+        if (n_args == 3) {
+            return pimpl->database.with_weak_read_lock([&]() {
+                return pimpl->get_account_history(account, from, limit);
+            });
+        }
+
+        auto op_names = args.args->at(3).as<std::vector<fc::variant>>();
+        bool ascending = n_args > 4 ? args.args->at(4).as<bool>() : false;
         return pimpl->database.with_weak_read_lock([&]() {
-            return pimpl->get_account_history(account, from, limit);
+            return pimpl->get_filtered_account_history(account, from, limit, op_names, ascending);
         });
     }
 
@@ -464,6 +753,10 @@ if( options.count(name) ) { \
             boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(),
             "Defines a range of accounts to track as a json pair [\"from\",\"to\"] [from,to]. "
             "Can be specified multiple times"
+        )(
+            "history-operation-type-index",
+            boost::program_options::value<bool>()->default_value(false),
+            "Index account history by types of operations to filter get_account_history by them"
         );
         cfg.add(cli);
     }
@@ -475,6 +768,9 @@ if( options.count(name) ) { \
         if (options.count("history-count-blocks")) {
             uint32_t history_count_blocks = options.at("history-count-blocks").as<uint32_t>();
             pimpl->history_count_blocks = history_count_blocks;
+            // purge options are defined by operation_history
+            pimpl->purge_interval = std::max<uint32_t>(options.at("history-purge-interval").as<uint32_t>(), 1);
+            pimpl->purge_limit = std::max<uint32_t>(options.at("history-purge-limit").as<uint32_t>(), 1);
             pimpl->database.applied_block.connect([&](const signed_block& block){
                 pimpl->purge_old_history();
             });
@@ -483,6 +779,16 @@ if( options.count(name) ) { \
         }
         ilog("account_history: history-count-blocks ${s}", ("s", pimpl->history_count_blocks));
 
+        // history-store is the option of operation_history, which also checks it
+        if (options.count("history-store") && options.at("history-store").as<std::string>() == "disk") {
+            pimpl->store_to_disk = true;
+            pimpl->store.open(appbase::app().data_dir() / "blockchain" / "account_history");
+            pimpl->database.applied_block.connect([&](const signed_block& block){
+                pimpl->move_irreversible_history();
+            });
+        }
+        ilog("account_history: store-to-disk ${s}", ("s", pimpl->store_to_disk));
+
         // this is worked, because the appbase initialize required plugins at first
         pimpl->database.pre_apply_operation.connect([&](graphene::chain::operation_notification& note){
             pimpl->on_operation(note);
@@ -491,6 +797,12 @@ if( options.count(name) ) { \
         graphene::chain::add_plugin_index<account_history_index>(pimpl->database);
         graphene::chain::add_plugin_index<account_range_index>(pimpl->database);
 
+        pimpl->index_operation_types = options.at("history-operation-type-index").as<bool>();
+        if (pimpl->index_operation_types) {
+            graphene::chain::add_plugin_index<account_operation_index>(pimpl->database);
+        }
+        ilog("account_history: history-operation-type-index ${s}", ("s", pimpl->index_operation_types));
+
         using pairstring = std::pair<std::string, std::string>;
         LOAD_VALUE_SET(options, "track-account-range", pimpl->tracked_accounts, pairstring);
 
@@ -515,6 +827,7 @@ if( options.count(name) ) { \
     }
 
     void plugin::plugin_shutdown() {
+        pimpl->store.close();
     }
 
     fc::flat_map<std::string, std::string> plugin::tracked_accounts() const {
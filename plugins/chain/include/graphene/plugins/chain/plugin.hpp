@@ -5,6 +5,7 @@
 #include <boost/signals2.hpp>
 #include <graphene/protocol/types.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/plugins/chain/write_queue.hpp>
 #include <graphene/protocol/block.hpp>
 
 #include <graphene/plugins/json_rpc/utility.hpp>
@@ -45,6 +46,16 @@ namespace graphene {
 
                 void accept_transaction(const protocol::signed_transaction &trx);
 
+                /**
+                 * The last irreversible block as of the last applied block, it doesn't take the read lock
+                 */
+                uint32_t last_irreversible_block_num() const;
+
+                /**
+                 * Statistics of queues of the write thread, it's empty if single-write-thread is disabled
+                 */
+                write_queue_stats get_write_queue_stats() const;
+
                 bool block_is_on_preferred_chain(const protocol::block_id_type &block_id);
 
                 void check_time_in_block(const protocol::signed_block &block);
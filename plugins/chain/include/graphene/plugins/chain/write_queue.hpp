@@ -0,0 +1,115 @@
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace graphene {
+    namespace plugins {
+        namespace chain {
+
+            /**
+             * Depth of queues and the time which tasks wait in them, in microseconds
+             */
+            struct write_queue_stats {
+                uint32_t block_queue_depth = 0;
+                uint32_t transaction_queue_depth = 0;
+
+                uint64_t pushed_blocks = 0;
+                uint64_t pushed_transactions = 0;
+                uint64_t transaction_batches = 0;
+                uint64_t interrupted_batches = 0;
+
+                int64_t last_block_wait = 0;
+                int64_t max_block_wait = 0;
+                int64_t total_block_wait = 0;
+                int64_t max_transaction_wait = 0;
+                int64_t total_transaction_wait = 0;
+            };
+
+            /**
+             * Pushes blocks and transactions to the database from the dedicated writer thread.
+             *
+             * Blocks have priority over transactions: a queued block is pushed before all queued transactions,
+             * and it interrupts the batch of transactions which is being pushed. Transactions are pushed in batches
+             * under one acquisition of the write lock.
+             *
+             * Callers wait until their block or transaction is pushed, so tasks refer to the data of callers.
+             */
+            class write_queue final {
+            public:
+                write_queue(graphene::chain::database &db, uint32_t transaction_batch_size);
+
+                ~write_queue();
+
+                void start();
+
+                /**
+                 * Stops the writer thread, waiting tasks fail
+                 */
+                void stop();
+
+                /**
+                 * Waits until the block is pushed, an exception of push_block() is rethrown
+                 */
+                bool push_block(const protocol::signed_block &block, uint32_t skip);
+
+                /**
+                 * Waits until the transaction is pushed, an exception of push_transaction() is rethrown
+                 */
+                void push_transaction(const graphene::chain::precomputed_transaction &trx, uint32_t skip);
+
+                write_queue_stats get_stats() const;
+
+            private:
+                struct block_task {
+                    const protocol::signed_block *block;
+                    uint32_t skip;
+                    fc::time_point queued;
+                    std::promise<bool> result;
+                };
+
+                struct transaction_task {
+                    const graphene::chain::precomputed_transaction *trx;
+                    uint32_t skip;
+                    fc::time_point queued;
+                    std::promise<void> result;
+                };
+
+                void write_loop();
+
+                void push_block_task(block_task &task);
+
+                void push_transaction_batch(std::vector<transaction_task *> &batch);
+
+                graphene::chain::database &_db;
+                const uint32_t _transaction_batch_size;
+
+                std::deque<block_task *> _blocks;
+                std::deque<transaction_task *> _transactions;
+                std::atomic<uint32_t> _queued_blocks{0};
+
+                mutable std::mutex _mutex;
+                std::condition_variable _cond;
+                std::thread _thread;
+                bool _stopped = false;
+
+                write_queue_stats _stats;
+            };
+
+        }
+    }
+} // graphene::plugins::chain
+
+FC_REFLECT(
+    (graphene::plugins::chain::write_queue_stats),
+    (block_queue_depth)(transaction_queue_depth)(pushed_blocks)(pushed_transactions)(transaction_batches)
+    (interrupted_batches)(last_block_wait)(max_block_wait)(total_block_wait)(max_transaction_wait)
+    (total_transaction_wait))
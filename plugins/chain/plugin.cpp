@@ -1,6 +1,7 @@
 #include <graphene/chain/database_exceptions.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/plugins/chain/plugin.hpp>
+#include <graphene/plugins/chain/write_queue.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/string.hpp>
@@ -8,8 +9,12 @@
 #include <iostream>
 #include <graphene/protocol/protocol.hpp>
 #include <graphene/protocol/types.hpp>
+#include <atomic>
 #include <future>
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 namespace graphene {
 namespace plugins {
 namespace chain {
@@ -48,11 +53,30 @@ namespace chain {
 
         uint32_t block_num_check_free_size = 0;
 
+        uint32_t replay_read_ahead_blocks = 1024;
+        uint32_t replay_decoder_threads = 2;
+
+        graphene::chain::block_log_compression block_log_compression = graphene::chain::block_log_compression::none;
+        uint32_t block_log_chunk_blocks = 256;
+        uint32_t block_log_chunk_cache = 64;
+
         bool skip_virtual_ops = false;
 
+        boost::filesystem::path export_state_snapshot;
+        boost::filesystem::path import_state_snapshot;
+
         graphene::chain::database db;
 
+        std::atomic<uint32_t> last_irreversible_block_num{0};
+
         bool single_write_thread = false;
+        uint32_t single_write_thread_batch_size = 64;
+        std::unique_ptr<write_queue> writer;
+
+        uint32_t signature_verification_threads = 0;
+        boost::asio::io_service verification_ios;
+        std::unique_ptr<boost::asio::io_service::work> verification_work;
+        boost::thread_group verification_threads;
 
         plugin_impl() {
             // get default settings
@@ -79,6 +103,9 @@ namespace chain {
         }
 
         void check_time_in_block(const protocol::signed_block &block);
+        void start_signature_verification();
+        void stop_signature_verification();
+        void precompute_signature_keys(const protocol::signed_block &block, uint32_t skip);
         bool accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip);
         void accept_transaction(const protocol::signed_transaction &trx);
         void wipe_db(const bfs::path &data_dir, bool wipe_block_log);
@@ -93,6 +120,58 @@ namespace chain {
         FC_ASSERT(block.timestamp.sec_since_epoch() <= max_accept_time);
     }
 
+    void plugin::plugin_impl::start_signature_verification() {
+        if (!signature_verification_threads) {
+            return;
+        }
+
+        verification_work.reset(new boost::asio::io_service::work(verification_ios));
+        for (uint32_t i = 0; i < signature_verification_threads; ++i) {
+            verification_threads.create_thread(boost::bind(&boost::asio::io_service::run, &verification_ios));
+        }
+    }
+
+    void plugin::plugin_impl::stop_signature_verification() {
+        if (!signature_verification_threads) {
+            return;
+        }
+
+        verification_work.reset();
+        verification_ios.stop();
+        verification_threads.join_all();
+    }
+
+    void plugin::plugin_impl::precompute_signature_keys(const protocol::signed_block &block, uint32_t skip) {
+        if (!verification_work ||
+            (skip & (graphene::chain::database::skip_transaction_signatures | graphene::chain::database::skip_authority_check))
+        ) {
+            return;
+        }
+
+        // keys are recovered in parallel without locking of database,
+        //   the authority check in push_block() takes them from the cache
+        std::vector<std::future<void>> results;
+        results.reserve(block.transactions.size());
+
+        for (const auto &trx : block.transactions) {
+            auto task = std::make_shared<std::packaged_task<void()>>([this, &trx]() {
+                try {
+                    db.precompute_signature_keys(trx);
+                } catch (const fc::exception &) {
+                    // invalid signatures will be reported on validation of the transaction
+                }
+            });
+            results.push_back(task->get_future());
+            verification_ios.post([task]() {
+                (*task)();
+            });
+        }
+
+        for (auto &result: results) {
+            result.wait();
+        }
+    }
+
     bool plugin::plugin_impl::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
         if (currently_syncing && block.block_num() % 10000 == 0) {
             ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
@@ -101,20 +180,12 @@ namespace chain {
 
         check_time_in_block(block);
 
-        skip = db.validate_block(block, skip);
+        precompute_signature_keys(block, skip);
 
-        if (single_write_thread) {
-            std::promise<bool> promise;
-            auto result = promise.get_future();
+        skip = db.validate_block(block, skip);
 
-            io_service().post([&]{
-                try {
-                    promise.set_value(db.push_block(block, skip));
-                } catch(...) {
-                    promise.set_exception(std::current_exception());
-                }
-            });
-            return result.get(); // if an exception was, it will be thrown
+        if (writer) {
+            return writer->push_block(block, skip); // if an exception was, it will be thrown
         } else {
             return db.push_block(block, skip);
         }
@@ -145,22 +216,23 @@ namespace chain {
         db.reindex(data_dir, shared_memory_dir, from_block_num, shared_memory_size);
     };
 
-    void plugin::plugin_impl::accept_transaction(const protocol::signed_transaction &trx) {
-        uint32_t skip = db.validate_transaction(trx, db.skip_apply_transaction);
+    void plugin::plugin_impl::accept_transaction(const protocol::signed_transaction &signed_trx) {
+        // the transaction is packed and hashed only once for validating and pushing
+        graphene::chain::precomputed_transaction trx(signed_trx);
+
+        if (signature_verification_threads) {
+            // recovered keys are cached for the block, which will include the transaction
+            try {
+                db.precompute_signature_keys(trx);
+            } catch (const fc::exception &) {
+                // invalid signatures will be reported by validate_transaction()
+            }
+        }
 
-        if (single_write_thread) {
-            std::promise<bool> promise;
-            auto wait = promise.get_future();
+        uint32_t skip = db.validate_transaction(trx, db.skip_apply_transaction);
 
-            io_service().post([&]{
-                try {
-                    db.push_transaction(trx, skip);
-                    promise.set_value(true);
-                } catch(...) {
-                    promise.set_exception(std::current_exception());
-                }
-            });
-            wait.get(); // if an exception was, it will be thrown
+        if (writer) {
+            writer->push_transaction(trx, skip); // if an exception was, it will be thrown
         } else {
             db.push_transaction(trx, skip);
         }
@@ -198,6 +270,21 @@ namespace chain {
             ) (
                 "block-num-check-free-size", boost::program_options::value<uint32_t>()->default_value(1000),
                 "Check free space in shared memory each N blocks. Default: 1000 (each 3000 seconds)."
+            ) (
+                "replay-read-ahead-blocks", boost::program_options::value<uint32_t>()->default_value(1024),
+                "Number of blocks which can be decoded ahead of applying on replay. Default: 1024"
+            ) (
+                "replay-decoder-threads", boost::program_options::value<uint32_t>()->default_value(2),
+                "Number of threads which read and decode blocks from block log on replay, 0 to decode in the writer thread. Default: 2"
+            ) (
+                "block-log-compression", boost::program_options::value<std::string>()->default_value("none"),
+                "Compression of a new block log: none, zstd or lz4. An existing block log keeps its format. Default: none"
+            ) (
+                "block-log-chunk-blocks", boost::program_options::value<uint32_t>()->default_value(256),
+                "Number of blocks in a compressed chunk of a new block log. Default: 256"
+            ) (
+                "block-log-chunk-cache", boost::program_options::value<uint32_t>()->default_value(64),
+                "Number of decompressed chunks of block log which are kept in memory. Default: 64"
             ) (
                 "checkpoint", boost::program_options::value<std::vector<std::string>>()->composing(),
                 "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints."
@@ -219,6 +306,12 @@ namespace chain {
             ) (
                 "single-write-thread", boost::program_options::value<bool>()->default_value(false),
                 "push blocks and transactions from one thread"
+            ) (
+                "single-write-thread-batch-size", boost::program_options::value<uint32_t>()->default_value(64),
+                "Max number of transactions which the write thread pushes under one write lock. Default: 64"
+            ) (
+                "signature-verification-threads", boost::program_options::value<uint32_t>()->default_value(2),
+                "Number of threads which recover public keys from signatures of transactions in a received block before pushing it, 0 to disable. Default: 2"
             ) (
                 "clear-votes-before-block", boost::program_options::value<uint32_t>()->default_value(0),
                 "remove votes before defined block, should speedup initial synchronization"
@@ -242,6 +335,12 @@ namespace chain {
             ) (
                 "resync-blockchain", boost::program_options::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "export-state-snapshot", boost::program_options::value<boost::filesystem::path>(),
+                "write the chain state into the snapshot file after opening the database and quit"
+            ) (
+                "import-state-snapshot", boost::program_options::value<boost::filesystem::path>(),
+                "clear chain database and load the state from the snapshot file, block log should contain its head block"
             ) (
                 "check-locks", boost::program_options::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
@@ -279,6 +378,9 @@ namespace chain {
         }
 
         my->single_write_thread = options.at("single-write-thread").as<bool>();
+        my->single_write_thread_batch_size = options.at("single-write-thread-batch-size").as<uint32_t>();
+        FC_ASSERT(my->single_write_thread_batch_size > 0, "single-write-thread-batch-size must be greater than 0");
+        my->signature_verification_threads = options.at("signature-verification-threads").as<uint32_t>();
 
         my->enable_plugins_on_push_transaction = options.at("enable-plugins-on-push-transaction").as<bool>();
 
@@ -291,10 +393,29 @@ namespace chain {
             my->block_num_check_free_size = options.at("block-num-check-free-size").as<uint32_t>();
         }
 
+        my->replay_read_ahead_blocks = options.at("replay-read-ahead-blocks").as<uint32_t>();
+        my->replay_decoder_threads = options.at("replay-decoder-threads").as<uint32_t>();
+        FC_ASSERT(my->replay_read_ahead_blocks > 0, "replay-read-ahead-blocks must be greater than 0");
+
+        my->block_log_compression = fc::reflector<graphene::chain::block_log_compression>::from_string(
+            options.at("block-log-compression").as<std::string>().c_str());
+        my->block_log_chunk_blocks = options.at("block-log-chunk-blocks").as<uint32_t>();
+        my->block_log_chunk_cache = options.at("block-log-chunk-cache").as<uint32_t>();
+        FC_ASSERT(graphene::chain::is_block_log_compression_supported(my->block_log_compression),
+            "block-log-compression ${c} isn't supported by this build", ("c", my->block_log_compression));
+        FC_ASSERT(my->block_log_chunk_blocks > 0, "block-log-chunk-blocks must be greater than 0");
+
         my->replay = options.at("replay-blockchain").as<bool>();
         my->replay_if_corrupted = options.at("replay-if-corrupted").as<bool>();
         my->force_replay = options.at("force-replay-blockchain").as<bool>();
         my->resync = options.at("resync-blockchain").as<bool>();
+        if (options.count("export-state-snapshot")) {
+            my->export_state_snapshot = options.at("export-state-snapshot").as<boost::filesystem::path>();
+        }
+        if (options.count("import-state-snapshot")) {
+            my->import_state_snapshot = options.at("import-state-snapshot").as<boost::filesystem::path>();
+            FC_ASSERT(!my->resync, "import-state-snapshot can't be used with resync-blockchain");
+        }
         my->check_locks = options.at("check-locks").as<bool>();
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
         if (options.count("flush-state-interval")) {
@@ -311,6 +432,12 @@ namespace chain {
                 my->loaded_checkpoints[item.first] = item.second;
             }
         }
+
+        my->db.applied_block.connect([this](const protocol::signed_block &) {
+            my->last_irreversible_block_num = my->db.last_non_undoable_block_num();
+            // cached results of the head scope are valid until the next block
+            appbase::app().get_plugin<json_rpc::plugin>().clear_head_cache();
+        });
     }
 
     void plugin::plugin_startup() {
@@ -343,8 +470,18 @@ namespace chain {
             my->db.set_block_num_check_free_size(my->block_num_check_free_size);
         }
 
+        my->db.set_reindex_decoding(my->replay_read_ahead_blocks, my->replay_decoder_threads);
+        my->db.set_block_log_compression(
+            my->block_log_compression, my->block_log_chunk_blocks, my->block_log_chunk_cache);
+
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
+        if (!my->import_state_snapshot.empty()) {
+            wlog("import-state-snapshot requested: deleting shared memory");
+            my->db.wipe(data_dir, my->shared_memory_dir, false);
+            my->db.set_state_snapshot_import(my->import_state_snapshot);
+        }
+
         try {
             ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
             my->db.open(data_dir, my->shared_memory_dir, CHAIN_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/ );
@@ -370,6 +507,10 @@ namespace chain {
                 return;
             }
         } catch (...) {
+            if (!my->import_state_snapshot.empty()) {
+                // don't replay the whole chain instead of a broken snapshot
+                throw;
+            }
             if (my->replay_if_corrupted) {
                 wlog("Error opening database, attempting to replay blockchain.");
                 try {
@@ -385,11 +526,29 @@ namespace chain {
             }
         }
 
+        if (!my->export_state_snapshot.empty()) {
+            my->db.export_state_snapshot(my->export_state_snapshot);
+            appbase::app().quit();
+            return;
+        }
+
+        my->start_signature_verification();
+
+        if (my->single_write_thread) {
+            my->writer.reset(new write_queue(my->db, my->single_write_thread_batch_size));
+            my->writer->start();
+        }
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
         on_sync();
     }
 
     void plugin::plugin_shutdown() {
+        if (my->writer) {
+            my->writer->stop();
+        }
+        my->stop_signature_verification();
+
         ilog("closing chain database");
         my->db.close();
         ilog("database closed successfully");
@@ -399,6 +558,17 @@ namespace chain {
         return my->accept_block(block, currently_syncing, skip);
     }
 
+    uint32_t plugin::last_irreversible_block_num() const {
+        return my->last_irreversible_block_num;
+    }
+
+    write_queue_stats plugin::get_write_queue_stats() const {
+        if (!my->writer) {
+            return write_queue_stats();
+        }
+        return my->writer->get_stats();
+    }
+
     void plugin::accept_transaction(const protocol::signed_transaction &trx) {
         my->accept_transaction(trx);
     }
@@ -0,0 +1,183 @@
+#include <graphene/plugins/chain/write_queue.hpp>
+
+namespace graphene {
+    namespace plugins {
+        namespace chain {
+
+            write_queue::write_queue(graphene::chain::database &db, uint32_t transaction_batch_size)
+                : _db(db),
+                  _transaction_batch_size(std::max<uint32_t>(transaction_batch_size, 1)) {
+            }
+
+            write_queue::~write_queue() {
+                stop();
+            }
+
+            void write_queue::start() {
+                _thread = std::thread([this]() {
+                    write_loop();
+                });
+            }
+
+            void write_queue::stop() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_stopped) {
+                        return;
+                    }
+                    _stopped = true;
+                }
+                _cond.notify_all();
+
+                if (_thread.joinable()) {
+                    _thread.join();
+                }
+
+                std::exception_ptr error;
+                try {
+                    FC_THROW("Write queue is stopped");
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (auto task : _blocks) {
+                    task->result.set_exception(error);
+                }
+                for (auto task : _transactions) {
+                    task->result.set_exception(error);
+                }
+                _blocks.clear();
+                _transactions.clear();
+            }
+
+            bool write_queue::push_block(const protocol::signed_block &block, uint32_t skip) {
+                block_task task{&block, skip, fc::time_point::now(), {}};
+                auto result = task.result.get_future();
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    FC_ASSERT(!_stopped, "Write queue is stopped");
+                    _blocks.push_back(&task);
+                    ++_queued_blocks;
+                }
+                _cond.notify_one();
+                return result.get();
+            }
+
+            void write_queue::push_transaction(const graphene::chain::precomputed_transaction &trx, uint32_t skip) {
+                transaction_task task{&trx, skip, fc::time_point::now(), {}};
+                auto result = task.result.get_future();
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    FC_ASSERT(!_stopped, "Write queue is stopped");
+                    _transactions.push_back(&task);
+                }
+                _cond.notify_one();
+                result.get();
+            }
+
+            write_queue_stats write_queue::get_stats() const {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto stats = _stats;
+                stats.block_queue_depth = _blocks.size();
+                stats.transaction_queue_depth = _transactions.size();
+                return stats;
+            }
+
+            void write_queue::write_loop() {
+                std::vector<transaction_task *> batch;
+                batch.reserve(_transaction_batch_size);
+
+                while (true) {
+                    block_task *block = nullptr;
+                    batch.clear();
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _cond.wait(lock, [&]() {
+                            return _stopped || !_blocks.empty() || !_transactions.empty();
+                        });
+                        if (_stopped) {
+                            return;
+                        }
+
+                        auto now = fc::time_point::now();
+                        if (!_blocks.empty()) {
+                            block = _blocks.front();
+                            _blocks.pop_front();
+                            --_queued_blocks;
+
+                            auto wait = (now - block->queued).count();
+                            _stats.last_block_wait = wait;
+                            _stats.max_block_wait = std::max(_stats.max_block_wait, wait);
+                            _stats.total_block_wait += wait;
+                        } else {
+                            while (!_transactions.empty() && batch.size() < _transaction_batch_size) {
+                                auto task = _transactions.front();
+                                _transactions.pop_front();
+                                batch.push_back(task);
+
+                                auto wait = (now - task->queued).count();
+                                _stats.max_transaction_wait = std::max(_stats.max_transaction_wait, wait);
+                                _stats.total_transaction_wait += wait;
+                            }
+                        }
+                    }
+
+                    if (block) {
+                        push_block_task(*block);
+                    } else {
+                        push_transaction_batch(batch);
+                    }
+                }
+            }
+
+            void write_queue::push_block_task(block_task &task) {
+                try {
+                    task.result.set_value(_db.push_block(*task.block, task.skip));
+                } catch (...) {
+                    task.result.set_exception(std::current_exception());
+                }
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_stats.pushed_blocks;
+            }
+
+            void write_queue::push_transaction_batch(std::vector<transaction_task *> &batch) {
+                graphene::chain::database::transaction_batch items;
+                items.reserve(batch.size());
+                for (auto task : batch) {
+                    items.emplace_back(task->trx, task->skip);
+                }
+
+                std::vector<std::exception_ptr> results;
+                try {
+                    // a queued block stops the batch
+                    results = _db.push_transactions(items, [this]() {
+                        return _queued_blocks.load() != 0;
+                    });
+                } catch (...) {
+                    // the write lock isn't acquired
+                    results.assign(batch.size(), std::current_exception());
+                }
+
+                for (size_t i = 0; i < results.size(); ++i) {
+                    if (results[i]) {
+                        batch[i]->result.set_exception(results[i]);
+                    } else {
+                        batch[i]->result.set_value();
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_stats.transaction_batches;
+                _stats.pushed_transactions += results.size();
+                if (results.size() < batch.size()) {
+                    // the rest of batch returns to the front of the queue
+                    ++_stats.interrupted_batches;
+                    _transactions.insert(_transactions.begin(), batch.begin() + results.size(), batch.end());
+                }
+            }
+
+        }
+    }
+} // graphene::plugins::chain
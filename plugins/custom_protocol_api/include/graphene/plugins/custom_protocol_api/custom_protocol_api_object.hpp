@@ -75,4 +75,4 @@ namespace graphene { namespace plugins { namespace custom_protocol_api {
 CHAINBASE_SET_INDEX_TYPE(
     graphene::plugins::custom_protocol_api::custom_protocol_object,
     graphene::plugins::custom_protocol_api::custom_protocol_index)
-FC_REFLECT((graphene::plugins::custom_protocol_api::custom_protocol_object),(account)(id)(custom_sequence)(custom_sequence_block_num));
\ No newline at end of file
+FC_REFLECT((graphene::plugins::custom_protocol_api::custom_protocol_object),(account)(id)(custom_protocol_id)(custom_sequence)(custom_sequence_block_num));
\ No newline at end of file
@@ -857,6 +857,15 @@ DEFINE_API(plugin, get_database_info) {
     return info;
 }
 
+DEFINE_API(plugin, get_node_stats) {
+    CHECK_ARG_SIZE(0);
+
+    node_stats stats;
+    stats.rpc = appbase::app().get_plugin<json_rpc::plugin>().get_stats();
+    stats.write_queue = appbase::app().get_plugin<chain::plugin>().get_write_queue_stats();
+    return stats;
+}
+
 std::vector<proposal_api_object> plugin::api_impl::get_proposed_transactions(
     const std::string& a, uint32_t from, uint32_t limit
 ) const {
@@ -913,6 +922,27 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
     ilog("database_api plugin: plugin_initialize() begin");
     my = std::make_unique<api_impl>();
     JSON_RPC_REGISTER_API(plugin_name)
+
+    using cache_scope = json_rpc::plugin::cache_scope;
+    auto &json_rpc = appbase::app().get_plugin<json_rpc::plugin>();
+    auto &chain = appbase::app().get_plugin<chain::plugin>();
+
+    // blocks up to the last irreversible block can't change
+    auto block_scope = [&chain](const msg_pack &args) {
+        auto block_num = args.args->at(0).as<uint32_t>();
+        return block_num <= chain.last_irreversible_block_num() ? cache_scope::immutable : cache_scope::head;
+    };
+    auto head_scope = [](const msg_pack &) {
+        return cache_scope::head;
+    };
+    json_rpc.add_cache_policy(plugin_name, "get_block", block_scope);
+    json_rpc.add_cache_policy(plugin_name, "get_block_header", block_scope);
+    json_rpc.add_cache_policy(plugin_name, "get_config", [](const msg_pack &) {
+        return cache_scope::immutable;
+    });
+    json_rpc.add_cache_policy(plugin_name, "get_chain_properties", head_scope);
+    json_rpc.add_cache_policy(plugin_name, "get_dynamic_global_properties", head_scope);
+
     my->database().applied_block.connect([this](const protocol::signed_block &) {
         this->clear_block_applied_callback();
     });
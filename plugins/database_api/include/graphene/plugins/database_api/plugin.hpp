@@ -44,6 +44,11 @@ struct database_info {
     std::vector<database_index_info> index_list;
 };
 
+struct node_stats {
+    std::vector<graphene::plugins::json_rpc::rpc_method_stats> rpc;
+    graphene::plugins::chain::write_queue_stats write_queue;
+};
+
 struct scheduled_hardfork {
     hardfork_version hf_version;
     fc::time_point_sec live_time;
@@ -162,6 +167,7 @@ DEFINE_API_ARGS(get_potential_signatures,         msg_pack, std::set<public_key_
 DEFINE_API_ARGS(verify_authority,                 msg_pack, bool)
 DEFINE_API_ARGS(verify_account_authority,         msg_pack, bool)
 DEFINE_API_ARGS(get_database_info,                msg_pack, database_info)
+DEFINE_API_ARGS(get_node_stats,                   msg_pack, node_stats)
 DEFINE_API_ARGS(get_proposed_transactions,        msg_pack, std::vector<proposal_api_object>)
 
 DEFINE_API_ARGS(get_accounts_on_sale,             msg_pack, std::vector<account_on_sale_api_object>)
@@ -384,6 +390,11 @@ public:
 
         (get_database_info)
 
+        /**
+         * @brief Get statistics of RPC calls per method (latencies in microseconds) and of the write queue
+         */
+        (get_node_stats)
+
         (get_proposed_transactions)
 
         /**
@@ -423,6 +434,7 @@ FC_REFLECT((graphene::plugins::database_api::signed_block_api_object), (block_id
 
 FC_REFLECT((graphene::plugins::database_api::database_index_info), (name)(record_count))
 FC_REFLECT((graphene::plugins::database_api::database_info), (total_size)(free_size)(reserved_size)(used_size)(index_list))
+FC_REFLECT((graphene::plugins::database_api::node_stats), (rpc)(write_queue))
 
 FC_REFLECT((graphene::plugins::database_api::account_on_sale_api_object), (account)(account_seller)(account_offer_price)(account_on_sale_start_time)(target_buyer)(current_bid)(current_bidder)(current_bidder_key)(last_bid))
 FC_REFLECT((graphene::plugins::database_api::subaccount_on_sale_api_object), (account)(subaccount_seller)(subaccount_offer_price))
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+
+#include <string>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * Writes JSON of variants directly to the output string.
+             *
+             * Unlike fc::json::to_string, it doesn't pass the text through a stringstream and
+             * doesn't convert enclosing structs into variants, so parts of a response (envelope, results of
+             * a batch) are appended to one buffer without copying of result trees.
+             * The output is formatted as fc::json::stringify_large_ints_and_doubles.
+             */
+            class json_writer final {
+            public:
+                explicit json_writer(std::string &out);
+
+                void write(const fc::variant &value);
+
+                void write(const fc::variant_object &value);
+
+                void write(const fc::variants &value);
+
+                void write_string(const std::string &value);
+
+                void write_raw(const char *value);
+
+                void write_raw(const std::string &value);
+
+                void write_raw(char value);
+
+            private:
+                std::string &_out;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
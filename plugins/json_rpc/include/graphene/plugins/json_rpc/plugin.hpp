@@ -81,10 +81,67 @@ namespace graphene {
                 fc::variant ret;
             };
 
+            /**
+             * Distribution of durations in microseconds,
+             * percentiles are upper bounds of power-of-two buckets
+             */
+            struct rpc_latency_stats {
+                uint64_t total = 0;
+                uint64_t max = 0;
+                uint64_t p50 = 0;
+                uint64_t p90 = 0;
+                uint64_t p99 = 0;
+            };
+
+            /**
+             * Statistics of calls of the method since the start of the node.
+             * Execution doesn't include the time of waiting for the read lock of the database,
+             * and the time of waiting in queues of the executor (e.g. of heavy calls and batches) before the call.
+             */
+            struct rpc_method_stats {
+                std::string method;
+                uint64_t calls = 0;
+                uint64_t errors = 0;
+                uint64_t bytes_out = 0;
+                rpc_latency_stats queue_wait;
+                rpc_latency_stats lock_wait;
+                rpc_latency_stats execution;
+                rpc_latency_stats serialization;
+            };
+
             class plugin final : public appbase::plugin<plugin> {
             public:
                 using response_handler_type = std::function<void (const std::string &)>;
 
+                /**
+                 * Lanes of the executor: heavy calls (see rpc-heavy-methods) are run separately,
+                 * so they can't occupy all threads of cheap calls
+                 */
+                enum class call_lane {
+                    fast,
+                    heavy
+                };
+
+                /**
+                 * Runs the task in the lane, e.g. posts it to the thread pool of the lane
+                 */
+                using task_executor_type = std::function<void (call_lane, std::function<void ()>)>;
+
+                /**
+                 * How long the result of a call can be returned from the cache:
+                 * none - it isn't cached, head - until the next block, immutable - always
+                 */
+                enum class cache_scope {
+                    none,
+                    head,
+                    immutable
+                };
+
+                /**
+                 * Returns the scope of the result of the call, it's called after the call with its arguments
+                 */
+                using cache_policy_type = std::function<cache_scope (const msg_pack &)>;
+
                 plugin();
 
                 ~plugin();
@@ -92,8 +149,7 @@ namespace graphene {
                 APPBASE_PLUGIN_REQUIRES();
 
                 void set_program_options(boost::program_options::options_description &,
-                                         boost::program_options::options_description &) override {
-                }
+                                         boost::program_options::options_description &) override;
 
                 static const std::string &name() {
                     static std::string name = JSON_RPC_PLUGIN_NAME;
@@ -111,6 +167,29 @@ namespace graphene {
 
                 void call(const string &body, response_handler_type);
 
+                /**
+                 * Calls of a batch request are run concurrently via the executor,
+                 * responses are assembled in the order of the batch.
+                 * Heavy methods are passed to the heavy lane of the executor.
+                 */
+                void call(const string &body, response_handler_type, task_executor_type);
+
+                /**
+                 * Enables caching of results of the method, results are keyed by arguments of calls.
+                 * Cached results are returned without calling of the method, see rpc-cache-size.
+                 */
+                void add_cache_policy(const string &api_name, const string &method_name, cache_policy_type);
+
+                /**
+                 * Drops cached results with the head scope, it should be called on each applied block
+                 */
+                void clear_head_cache();
+
+                /**
+                 * Returns statistics of called methods, calls of unknown methods are counted as "unknown"
+                 */
+                std::vector<rpc_method_stats> get_stats() const;
+
             private:
                 class impl;
 
@@ -143,4 +222,8 @@ namespace graphene {
     }
 } // graphene::plugins::json_rpc
 
-FC_REFLECT((graphene::plugins::json_rpc::api_method_signature), (args)(ret))
\ No newline at end of file
+FC_REFLECT((graphene::plugins::json_rpc::api_method_signature), (args)(ret))
+FC_REFLECT((graphene::plugins::json_rpc::rpc_latency_stats), (total)(max)(p50)(p90)(p99))
+FC_REFLECT(
+    (graphene::plugins::json_rpc::rpc_method_stats),
+    (method)(calls)(errors)(bytes_out)(queue_wait)(lock_wait)(execution)(serialization))
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <fc/optional.hpp>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * Results of calls rendered to JSON, keyed by the method and its arguments.
+             *
+             * Immutable results are valid until they are evicted, head results are valid until the next block:
+             * clear_head() starts a new generation of the cache, and results which are calculated
+             * in previous generations are neither returned nor stored.
+             * When the size of stored results exceeds the limit, the least recently used results are evicted.
+             */
+            class response_cache final {
+            public:
+                void set_max_size(std::size_t max_size);
+
+                bool enabled() const;
+
+                uint64_t generation() const;
+
+                fc::optional<std::string> find(const std::string &key) const;
+
+                void store(const std::string &key, std::string result, bool immutable, uint64_t generation);
+
+                void clear_head();
+
+            private:
+                struct entry {
+                    std::string key;
+                    std::string result;
+                    bool immutable;
+                    uint64_t generation;
+                };
+
+                using entry_list = std::list<entry>;
+
+                void erase(entry_list::iterator itr);
+
+                mutable std::mutex _mutex;
+                mutable entry_list _entries; // the most recently used entries are at the front
+                std::unordered_map<std::string, entry_list::iterator> _positions;
+                std::size_t _size = 0;
+                std::size_t _max_size = 0;
+                uint64_t _generation = 0;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
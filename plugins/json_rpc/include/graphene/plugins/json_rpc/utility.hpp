@@ -77,6 +77,9 @@ namespace graphene {
 
                 fc::optional<fc::variant> result() const;
 
+                // Pass result, which is already rendered to JSON, to remote connection
+                void rendered_result(std::string json);
+
                 // Pass error to remote connection
                 void error(int32_t code, std::string message, fc::optional<fc::variant> data = fc::optional<fc::variant>());
 
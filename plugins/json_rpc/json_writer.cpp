@@ -0,0 +1,156 @@
+#include <graphene/plugins/json_rpc/json_writer.hpp>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            json_writer::json_writer(std::string &out)
+                : _out(out) {
+            }
+
+            void json_writer::write(const fc::variant &value) {
+                switch (value.get_type()) {
+                    case fc::variant::null_type:
+                        write_raw("null");
+                        break;
+
+                    case fc::variant::int64_type: {
+                        auto i = value.as_int64();
+                        if (i > 0xffffffff) {
+                            write_raw('"');
+                            _out += std::to_string(i);
+                            write_raw('"');
+                        } else {
+                            _out += std::to_string(i);
+                        }
+                        break;
+                    }
+
+                    case fc::variant::uint64_type: {
+                        auto i = value.as_uint64();
+                        if (i > 0xffffffff) {
+                            write_raw('"');
+                            _out += std::to_string(i);
+                            write_raw('"');
+                        } else {
+                            _out += std::to_string(i);
+                        }
+                        break;
+                    }
+
+                    case fc::variant::double_type:
+                        write_raw('"');
+                        _out += value.as_string();
+                        write_raw('"');
+                        break;
+
+                    case fc::variant::bool_type:
+                        write_raw(value.as_bool() ? "true" : "false");
+                        break;
+
+                    case fc::variant::string_type:
+                        write_string(value.get_string());
+                        break;
+
+                    case fc::variant::blob_type:
+                        write_string(value.as_string());
+                        break;
+
+                    case fc::variant::array_type:
+                        write(value.get_array());
+                        break;
+
+                    case fc::variant::object_type:
+                        write(value.get_object());
+                        break;
+
+                    default:
+                        FC_THROW_EXCEPTION(fc::invalid_arg_exception, "Unknown variant type ${t}",
+                            ("t", static_cast<int>(value.get_type())));
+                }
+            }
+
+            void json_writer::write(const fc::variant_object &value) {
+                write_raw('{');
+                bool first = true;
+                for (const auto &entry : value) {
+                    if (!first) {
+                        write_raw(',');
+                    }
+                    first = false;
+                    write_string(entry.key());
+                    write_raw(':');
+                    write(entry.value());
+                }
+                write_raw('}');
+            }
+
+            void json_writer::write(const fc::variants &value) {
+                write_raw('[');
+                bool first = true;
+                for (const auto &item : value) {
+                    if (!first) {
+                        write_raw(',');
+                    }
+                    first = false;
+                    write(item);
+                }
+                write_raw(']');
+            }
+
+            void json_writer::write_string(const std::string &value) {
+                static const char hex[] = "0123456789abcdef";
+
+                _out.reserve(_out.size() + value.size() + 2);
+                write_raw('"');
+                for (auto c: value) {
+                    switch (c) {
+                        case '"':
+                            _out += "\\\"";
+                            break;
+                        case '\\':
+                            _out += "\\\\";
+                            break;
+                        case '\b':
+                            _out += "\\b";
+                            break;
+                        case '\f':
+                            _out += "\\f";
+                            break;
+                        case '\n':
+                            _out += "\\n";
+                            break;
+                        case '\r':
+                            _out += "\\r";
+                            break;
+                        case '\t':
+                            _out += "\\t";
+                            break;
+                        default:
+                            if (static_cast<unsigned char>(c) < 0x20 || c == 0x7f) {
+                                _out += "\\u00";
+                                _out += hex[(c >> 4) & 0x0f];
+                                _out += hex[c & 0x0f];
+                            } else {
+                                _out += c;
+                            }
+                    }
+                }
+                write_raw('"');
+            }
+
+            void json_writer::write_raw(const char *value) {
+                _out += value;
+            }
+
+            void json_writer::write_raw(const std::string &value) {
+                _out += value;
+            }
+
+            void json_writer::write_raw(char value) {
+                _out += value;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
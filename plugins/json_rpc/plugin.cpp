@@ -1,8 +1,17 @@
 #include <graphene/plugins/json_rpc/plugin.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
+#include <graphene/plugins/json_rpc/json_writer.hpp>
+#include <graphene/plugins/json_rpc/response_cache.hpp>
+
+#include <graphene/chain/database.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <set>
+
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
 #include <thirdparty/fc/vendor/websocketpp/websocketpp/error.hpp>
@@ -29,6 +38,109 @@ namespace graphene {
                 fc::optional<fc::variant> result;
                 fc::optional<json_rpc_error> error;
                 fc::variant id;
+
+                // the result, which is already rendered to JSON, e.g. taken from the cache
+                fc::optional<std::string> rendered_result;
+            };
+
+            // The response is written field by field, fc::json::to_string(response) would copy the result
+            //    into the variant of the response before the rendering
+            static void write_response(json_writer &writer, const json_rpc_response &response) {
+                writer.write_raw("{\"jsonrpc\":");
+                writer.write_string(response.jsonrpc);
+                if (response.rendered_result.valid()) {
+                    writer.write_raw(",\"result\":");
+                    writer.write_raw(*response.rendered_result);
+                } else if (response.result.valid()) {
+                    writer.write_raw(",\"result\":");
+                    writer.write(*response.result);
+                }
+                if (response.error.valid()) {
+                    writer.write_raw(",\"error\":{\"code\":");
+                    writer.write(fc::variant(response.error->code));
+                    writer.write_raw(",\"message\":");
+                    writer.write_string(response.error->message);
+                    if (response.error->data.valid()) {
+                        writer.write_raw(",\"data\":");
+                        writer.write(*response.error->data);
+                    }
+                    writer.write_raw('}');
+                }
+                writer.write_raw(",\"id\":");
+                writer.write(response.id);
+                writer.write_raw('}');
+            }
+
+            static std::string to_json(const json_rpc_response &response) {
+                std::string result;
+                json_writer writer(result);
+                write_response(writer, response);
+                return result;
+            }
+
+            // Durations in microseconds, the bucket i counts durations in [2^(i-1), 2^i)
+            struct latency_histogram final {
+                std::array<uint64_t, 40> buckets{};
+                uint64_t count = 0;
+                uint64_t total = 0;
+                uint64_t max = 0;
+
+                void add(int64_t value) {
+                    uint64_t duration = std::max<int64_t>(value, 0);
+                    std::size_t bucket = 0;
+                    while (bucket + 1 < buckets.size() && (duration >> bucket) != 0) {
+                        ++bucket;
+                    }
+                    ++buckets[bucket];
+                    ++count;
+                    total += duration;
+                    max = std::max(max, duration);
+                }
+
+                uint64_t percentile(uint32_t percent) const {
+                    uint64_t target = (count * percent + 99) / 100;
+                    uint64_t seen = 0;
+                    for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+                        seen += buckets[bucket];
+                        if (seen >= target && seen != 0) {
+                            return std::min(max, (uint64_t(1) << bucket) - 1);
+                        }
+                    }
+                    return max;
+                }
+
+                rpc_latency_stats get_stats() const {
+                    rpc_latency_stats result;
+                    result.total = total;
+                    result.max = max;
+                    result.p50 = percentile(50);
+                    result.p90 = percentile(90);
+                    result.p99 = percentile(99);
+                    return result;
+                }
+            };
+
+            struct method_stats final {
+                uint64_t calls = 0;
+                uint64_t errors = 0;
+                uint64_t bytes_out = 0;
+                latency_histogram queue_wait;
+                latency_histogram lock_wait;
+                latency_histogram execution;
+                latency_histogram serialization;
+            };
+
+            // Timings of one call, they are recorded on rendering of the response
+            struct call_context final {
+                std::string method = "unknown";
+                fc::time_point received = fc::time_point::now();
+                fc::time_point start = received; // of the execution, calls wait in queues of the executor before it
+                int64_t lock_wait = 0;
+
+                // set if results of the method are cached
+                const plugin::cache_policy_type *cache_policy = nullptr;
+                std::string cache_key;
+                uint64_t cache_generation = 0;
             };
 
             struct msg_pack::impl final {
@@ -103,6 +215,18 @@ namespace graphene {
                 }
             }
 
+            void msg_pack::rendered_result(std::string json) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->response.rendered_result = std::move(json);
+                try {
+                    pimpl->handler(pimpl->response);
+                } catch (const websocketpp::exception &) {
+                    // Can't send data via socket -
+                    //    don't pass exception to upper level, because it doesn't have handler for exception
+                }
+            }
+
             fc::optional<fc::variant> msg_pack::result() const {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 if (valid()) {
@@ -212,7 +336,61 @@ namespace graphene {
                     return ret;
                 }
 
-                void rpc_jsonrpc(const fc::variant_object &request, msg_pack &msg) {
+                bool is_heavy_method(const std::string &method) const {
+                    return heavy_methods.count(method) != 0;
+                }
+
+                void call_api_method(api_method &call, msg_pack &msg, call_context &ctx) {
+                    ctx.start = fc::time_point::now();
+                    try {
+                        auto lock_wait = graphene::chain::database::read_lock_wait();
+                        auto result = call(msg);
+                        if (msg.valid()) {
+                            // the lock wait of delegated calls isn't known
+                            ctx.lock_wait = graphene::chain::database::read_lock_wait() - lock_wait;
+
+                            auto scope = ctx.cache_policy ? (*ctx.cache_policy)(msg) : cache_scope::none;
+                            if (scope != cache_scope::none) {
+                                std::string json;
+                                json_writer writer(json);
+                                writer.write(result);
+                                cache.store(ctx.cache_key, json, scope == cache_scope::immutable, ctx.cache_generation);
+                                msg.rendered_result(std::move(json));
+                            } else {
+                                msg.result(std::move(result));
+                            }
+                        }
+                    } catch (const fc::assert_exception &e) {
+                        msg.error(JSON_RPC_ERROR_DURING_CALL, e);
+                    }
+                }
+
+                // Passes the cached result of the call, returns false if there is no such result
+                bool find_cached_result(msg_pack &msg, call_context &ctx) {
+                    if (!cache.enabled()) {
+                        return false;
+                    }
+
+                    auto itr = cache_policies.find(ctx.method);
+                    if (itr == cache_policies.end()) {
+                        return false;
+                    }
+
+                    ctx.cache_policy = &itr->second;
+                    ctx.cache_key = ctx.method + fc::json::to_string(msg.args.valid() ? fc::variant(*msg.args) : fc::variant());
+                    ctx.cache_generation = cache.generation();
+
+                    auto result = cache.find(ctx.cache_key);
+                    if (!result.valid()) {
+                        return false;
+                    }
+                    msg.rendered_result(std::move(*result));
+                    return true;
+                }
+
+                void rpc_jsonrpc(
+                    const fc::variant_object &request, msg_pack &msg, const task_executor_type &executor, call_context &ctx
+                ) {
                     // TODO: id is optional value or not?
                     if (request.contains("id")) {
                         msg.rpc_id(request["id"]);
@@ -241,14 +419,23 @@ namespace graphene {
                         } catch (const fc::assert_exception &e) {
                             return msg.error(JSON_RPC_PARSE_PARAMS_ERROR, e);
                         }
+                        ctx.method = msg.plugin + '.' + msg.method;
 
-                        try {
-                            auto result = (*call)(msg);
-                            if (msg.valid()) {
-                                msg.result(std::move(result));
-                            }
-                        } catch (const fc::assert_exception &e) {
-                            return msg.error(JSON_RPC_ERROR_DURING_CALL, e);
+                        if (find_cached_result(msg, ctx)) {
+                            return;
+                        }
+
+                        if (executor && is_heavy_method(msg.method)) {
+                            // msg_pack is movable only, and tasks are copyable
+                            auto heavy_msg = std::make_shared<msg_pack>(std::move(msg));
+                            // the context lives in the handler of the msg_pack
+                            executor(call_lane::heavy, [this, call, heavy_msg, &ctx]{
+                                handle_errors(*heavy_msg, [&]{
+                                    call_api_method(*call, *heavy_msg, ctx);
+                                });
+                            });
+                        } else {
+                            call_api_method(*call, msg, ctx);
                         }
                     } else {
                         return msg.error(JSON_RPC_NO_PARAMS, "A member \"params\" does not exist");
@@ -287,52 +474,158 @@ namespace graphene {
                     const fc::variant& data_;
                 };
 
-                void rpc(const fc::variant& data, msg_pack& msg) {
-                    dump_rpc_time dump(data);
-
+                // Passes exceptions of the call to the msg_pack, returns the description of the error
+                template <typename Call>
+                static std::string handle_errors(msg_pack& msg, Call&& call) {
                     try {
-                        rpc_jsonrpc(data.get_object(), msg);
+                        call();
                     } catch (const fc::parse_error_exception& e) {
                         msg.error(JSON_RPC_INVALID_PARAMS, e);
-                        dump.error("invalid params");
+                        return "invalid params";
                     } catch (const fc::bad_cast_exception& e) {
                         msg.error(JSON_RPC_INVALID_PARAMS, e);
-                        dump.error("invalid types");
+                        return "invalid types";
                     } catch (const fc::exception& e) {
                         msg.error(e);
-                        dump.error("invalid request");
+                        return "invalid request";
                     } catch (const std::exception& e) {
                         msg.error(e.what());
-                        dump.error(e.what());
+                        return e.what();
                     } catch (...) {
                         msg.error("Unknown error - parsing rpc message failed");
-                        dump.error("unknown");
+                        return "unknown";
                     }
+                    return std::string();
                 }
 
-                void rpc(vector<fc::variant> messages, response_handler_type response_handler) {
-                    auto responses = std::make_shared<vector<json_rpc_response>>();
+                void rpc(const fc::variant& data, msg_pack& msg, const task_executor_type &executor, call_context &ctx) {
+                    dump_rpc_time dump(data);
 
-                    responses->reserve(messages.size());
+                    auto error = handle_errors(msg, [&]{
+                        rpc_jsonrpc(data.get_object(), msg, executor, ctx);
+                    });
+                    if (!error.empty()) {
+                        dump.error(std::move(error));
+                    }
+                }
 
-                    std::function<void()> next_handler = [response_handler, responses]{
-                        response_handler(fc::json::to_string(*responses.get()));
-                    };
+                struct batch_state final {
+                    vector<fc::variant> messages;
+                    vector<std::string> responses;
+                    std::atomic<std::size_t> next_message{0};
+                    std::atomic<std::size_t> remaining{0};
+                    response_handler_type response_handler;
+                    task_executor_type executor;
+                };
 
-                    for (auto it = messages.rbegin(); messages.rend() != it; ++it) {
-                        auto v = *it;
+                void rpc(vector<fc::variant> messages, response_handler_type response_handler, task_executor_type executor) {
+                    FC_ASSERT(messages.size() <= batch_max_size,
+                        "Batch of ${n} calls is greater than maximum allowed (${m})",
+                        ("n", messages.size())("m", batch_max_size));
 
-                        next_handler = [next_handler, responses, v, this]{
-                            msg_pack msg([next_handler, responses](json_rpc_response &response){
-                                responses->push_back(response);
-                                next_handler();
+                    std::size_t concurrency = batch_concurrency;
+                    if (!executor) {
+                        executor = [](call_lane, std::function<void()> task) {
+                            task();
+                        };
+                        concurrency = 1;
+                    }
+
+                    auto batch = std::make_shared<batch_state>();
+                    batch->messages = std::move(messages);
+                    batch->responses.resize(batch->messages.size());
+                    batch->remaining = batch->messages.size();
+                    batch->response_handler = std::move(response_handler);
+                    batch->executor = std::move(executor);
+
+                    concurrency = std::min(concurrency, batch->messages.size());
+                    for (std::size_t i = 0; i < concurrency; ++i) {
+                        batch->executor(call_lane::fast, [this, batch]{
+                            rpc_batch_next(batch);
+                        });
+                    }
+                }
+
+                void rpc_batch_next(const std::shared_ptr<batch_state> &batch) {
+                    auto idx = batch->next_message++;
+                    if (idx >= batch->messages.size()) {
+                        return;
+                    }
+
+                    // the handler can be called from any thread, when the call was delegated
+                    auto ctx = std::make_shared<call_context>();
+                    msg_pack msg([this, batch, idx, ctx](json_rpc_response &response){
+                        // responses are rendered by threads of their calls, and only joined at the end
+                        batch->responses[idx] = render_response(*ctx, response);
+                        if (--batch->remaining == 0) {
+                            batch->response_handler(join_responses(batch->responses));
+                        } else {
+                            // the completed call frees the place for the next call of the batch
+                            batch->executor(call_lane::fast, [this, batch]{
+                                rpc_batch_next(batch);
                             });
+                        }
+                    });
 
-                            this->rpc(v, msg);
-                        };
+                    this->rpc(batch->messages[idx], msg, batch->executor, *ctx);
+                }
+
+                std::string render_response(const call_context &ctx, const json_rpc_response &response) {
+                    auto serialization_start = fc::time_point::now();
+                    auto result = to_json(response);
+                    auto end = fc::time_point::now();
+
+                    std::lock_guard<std::mutex> lock(stats_mutex);
+                    auto &stats = method_stats_map[ctx.method];
+                    ++stats.calls;
+                    if (response.error.valid()) {
+                        ++stats.errors;
                     }
+                    stats.bytes_out += result.size();
+                    stats.queue_wait.add((ctx.start - ctx.received).count());
+                    stats.lock_wait.add(ctx.lock_wait);
+                    stats.execution.add((serialization_start - ctx.start).count() - ctx.lock_wait);
+                    stats.serialization.add((end - serialization_start).count());
+                    return result;
+                }
 
-                    next_handler();
+                std::vector<rpc_method_stats> get_stats() const {
+                    std::vector<rpc_method_stats> result;
+
+                    std::lock_guard<std::mutex> lock(stats_mutex);
+                    result.reserve(method_stats_map.size());
+                    for (const auto &item: method_stats_map) {
+                        rpc_method_stats stats;
+                        stats.method = item.first;
+                        stats.calls = item.second.calls;
+                        stats.errors = item.second.errors;
+                        stats.bytes_out = item.second.bytes_out;
+                        stats.queue_wait = item.second.queue_wait.get_stats();
+                        stats.lock_wait = item.second.lock_wait.get_stats();
+                        stats.execution = item.second.execution.get_stats();
+                        stats.serialization = item.second.serialization.get_stats();
+                        result.push_back(std::move(stats));
+                    }
+                    return result;
+                }
+
+                static std::string join_responses(const vector<std::string> &responses) {
+                    std::size_t size = responses.size() + 1;
+                    for (const auto &response: responses) {
+                        size += response.size();
+                    }
+
+                    std::string result;
+                    result.reserve(size);
+                    result += '[';
+                    for (std::size_t i = 0; i < responses.size(); ++i) {
+                        if (i) {
+                            result += ',';
+                        }
+                        result += responses[i];
+                    }
+                    result += ']';
+                    return result;
                 }
 
                 void initialize() {
@@ -356,6 +649,16 @@ namespace graphene {
                     return _method_reindex[method_name];                        
                 }
 
+                uint32_t batch_max_size = 1000;
+                uint32_t batch_concurrency = 8;
+                std::set<std::string> heavy_methods;
+
+                std::map<string, cache_policy_type> cache_policies;
+                response_cache cache;
+
+                mutable std::mutex stats_mutex;
+                std::map<std::string, method_stats> method_stats_map;
+
                 map<string, api_description> _registered_apis;
                 vector<string> _methods;
                 map<string, map<string, api_method_signature> > _method_sigs;
@@ -375,10 +678,54 @@ namespace graphene {
             plugin::~plugin() {
             }
 
+            void plugin::set_program_options(boost::program_options::options_description &,
+                                             boost::program_options::options_description &cfg) {
+                cfg.add_options()
+                    ("rpc-batch-max-size", boost::program_options::value<uint32_t>()->default_value(1000),
+                        "Maximum number of calls in a batch request.")
+                    ("rpc-batch-concurrency", boost::program_options::value<uint32_t>()->default_value(8),
+                        "Maximum number of calls of a batch request, which are run concurrently.")
+                    ("rpc-cache-size", boost::program_options::value<uint32_t>()->default_value(64),
+                        "Size of the cache of results of calls in megabytes, 0 disables the cache.")
+                    ("rpc-heavy-methods", boost::program_options::value<vector<string>>()->composing()->multitoken(),
+                        "Names of methods, which are run in the separate thread pool (webserver-heavy-thread-pool-size). "
+                        "Default: discussions, history and feed queries.");
+            }
+
             void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 ilog("json_rpc plugin: plugin_initialize() begin");
                 pimpl = std::make_unique<impl>();
                 pimpl->initialize();
+
+                pimpl->batch_max_size = options.at("rpc-batch-max-size").as<uint32_t>();
+                pimpl->batch_concurrency = options.at("rpc-batch-concurrency").as<uint32_t>();
+                pimpl->cache.set_max_size(std::size_t(options.at("rpc-cache-size").as<uint32_t>()) * 1024 * 1024);
+                FC_ASSERT(pimpl->batch_max_size > 0, "rpc-batch-max-size must be greater than 0");
+                FC_ASSERT(pimpl->batch_concurrency > 0, "rpc-batch-concurrency must be greater than 0");
+
+                if (options.count("rpc-heavy-methods")) {
+                    for (const auto &raw: options.at("rpc-heavy-methods").as<vector<string>>()) {
+                        vector<string> methods;
+                        boost::split(methods, raw, boost::is_any_of(" \t,"));
+                        for (const auto &method: methods) {
+                            if (!method.empty()) {
+                                pimpl->heavy_methods.insert(method);
+                            }
+                        }
+                    }
+                } else {
+                    pimpl->heavy_methods = {
+                        "get_discussions_by_active", "get_discussions_by_author_before_date", "get_discussions_by_blog",
+                        "get_discussions_by_cashout", "get_discussions_by_children", "get_discussions_by_contents",
+                        "get_discussions_by_created", "get_discussions_by_feed", "get_discussions_by_hot",
+                        "get_discussions_by_payout", "get_discussions_by_trending", "get_discussions_by_votes",
+                        "get_all_content_replies", "get_content_replies", "get_replies_by_last_update",
+                        "get_trending_tags", "get_account_history", "get_blog", "get_blog_entries",
+                        "get_feed", "get_feed_entries", "get_followers", "get_following",
+                        "get_raw_blocks", "get_blocks_with_info"};
+                }
+                ilog("json_rpc: batch max size ${s}, concurrency ${c}",
+                    ("s", pimpl->batch_max_size)("c", pimpl->batch_concurrency));
                 ilog("json_rpc plugin: plugin_initialize() end");
             }
 
@@ -399,7 +746,23 @@ namespace graphene {
                 pimpl->add_api_method(api_name, method_name, api/*, sig*/ );
             }
 
+            void plugin::add_cache_policy(const string &api_name, const string &method_name, cache_policy_type policy) {
+                pimpl->cache_policies[api_name + '.' + method_name] = std::move(policy);
+            }
+
+            void plugin::clear_head_cache() {
+                pimpl->cache.clear_head();
+            }
+
+            std::vector<rpc_method_stats> plugin::get_stats() const {
+                return pimpl->get_stats();
+            }
+
             void plugin::call(const string &message, response_handler_type response_handler) {
+                call(message, std::move(response_handler), task_executor_type());
+            }
+
+            void plugin::call(const string &message, response_handler_type response_handler, task_executor_type executor) {
                 try {
                     fc::variant v = fc::json::from_string(message);
 
@@ -407,18 +770,19 @@ namespace graphene {
                         vector<fc::variant> messages = v.as<vector<fc::variant>>();
 
                         FC_ASSERT(messages.size(), "Array is invalid");
-                        pimpl->rpc(messages, response_handler);
+                        pimpl->rpc(std::move(messages), response_handler, std::move(executor));
                     } else {
-                        msg_pack msg([response_handler](json_rpc_response &response){
-                            response_handler(fc::json::to_string(response));
+                        auto ctx = std::make_shared<call_context>();
+                        msg_pack msg([this, response_handler, ctx](json_rpc_response &response){
+                            response_handler(pimpl->render_response(*ctx, response));
                         });
 
-                        pimpl->rpc(v, msg);
+                        pimpl->rpc(v, msg, executor, *ctx);
                     }
                 } catch (const fc::exception &e) {
                     json_rpc_response response;
                     response.error = json_rpc_error(JSON_RPC_SERVER_ERROR, e.to_string(), fc::variant(*(e.dynamic_copy_exception())));
-                    response_handler(fc::json::to_string(response));
+                    response_handler(to_json(response));
                 }
             }
         }
@@ -0,0 +1,79 @@
+#include <graphene/plugins/json_rpc/response_cache.hpp>
+
+#include <iterator>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            void response_cache::set_max_size(std::size_t max_size) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _max_size = max_size;
+            }
+
+            bool response_cache::enabled() const {
+                std::lock_guard<std::mutex> lock(_mutex);
+                return _max_size != 0;
+            }
+
+            uint64_t response_cache::generation() const {
+                std::lock_guard<std::mutex> lock(_mutex);
+                return _generation;
+            }
+
+            fc::optional<std::string> response_cache::find(const std::string &key) const {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto itr = _positions.find(key);
+                if (itr == _positions.end()) {
+                    return {};
+                }
+                const auto &item = *itr->second;
+                if (!item.immutable && item.generation != _generation) {
+                    return {};
+                }
+                _entries.splice(_entries.begin(), _entries, itr->second);
+                return item.result;
+            }
+
+            void response_cache::store(const std::string &key, std::string result, bool immutable, uint64_t generation) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto size = key.size() + result.size();
+                if (generation != _generation || size > _max_size) {
+                    return;
+                }
+
+                auto itr = _positions.find(key);
+                if (itr != _positions.end()) {
+                    erase(itr->second);
+                }
+
+                while (_size + size > _max_size) {
+                    erase(std::prev(_entries.end()));
+                }
+
+                _entries.push_front(entry{key, std::move(result), immutable, generation});
+                _positions.emplace(key, _entries.begin());
+                _size += size;
+            }
+
+            void response_cache::clear_head() {
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_generation;
+                for (auto itr = _entries.begin(); itr != _entries.end();) {
+                    auto next = std::next(itr);
+                    if (!itr->immutable) {
+                        erase(itr);
+                    }
+                    itr = next;
+                }
+            }
+
+            void response_cache::erase(entry_list::iterator itr) {
+                _size -= itr->key.size() + itr->result.size();
+                _positions.erase(itr->key);
+                _entries.erase(itr);
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
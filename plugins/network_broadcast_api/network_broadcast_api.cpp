@@ -160,9 +160,10 @@ namespace graphene {
                     boost::lock_guard< boost::mutex > guard( pimpl->_mtx );
                     int32_t block_num = int32_t(b.block_num());
                     if( pimpl->_callbacks.size() ) {
-                        for( size_t trx_num = 0; trx_num < b.transactions.size(); ++trx_num ) {
-                            const auto& trx = b.transactions[trx_num];
-                            auto id = trx.id();
+                        // ids are already calculated on applying of the block
+                        const auto& transactions = appbase::app().get_plugin<chain::plugin>().db().get_applied_block_transactions();
+                        for( size_t trx_num = 0; trx_num < transactions.size(); ++trx_num ) {
+                            const auto& id = transactions[trx_num].id();
                             auto itr = pimpl->_callbacks.find( id );
                             if( itr ==pimpl-> _callbacks.end() ) continue;
                             itr->second( broadcast_transaction_synchronous_t( id, block_num, int32_t( trx_num ), false ) );
@@ -0,0 +1,418 @@
+#include <graphene/plugins/operation_history/history_store.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace graphene { namespace plugins { namespace operation_history {
+
+    static void open_file(std::fstream& file, const fc::path& path) {
+        if (!fc::exists(path)) {
+            std::ofstream(path.generic_string(), std::ios::out | std::ios::binary);
+        }
+        file.open(path.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+        FC_ASSERT(file.good(), "Can't open ${p}", ("p", path));
+    }
+
+    static int open_fd(const fc::path& path) {
+        int fd = ::open(path.generic_string().c_str(), O_RDONLY | O_CLOEXEC);
+        FC_ASSERT(fd >= 0, "Can't open ${p}", ("p", path));
+        return fd;
+    }
+
+    static void close_fd(int& fd) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    static void read_at(int fd, uint64_t pos, char* data, std::size_t size) {
+        while (size > 0) {
+            auto count = ::pread(fd, data, size, pos);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            FC_ASSERT(count > 0, "Can't read operation history store");
+            data += count;
+            size -= count;
+            pos += count;
+        }
+    }
+
+    history_store::~history_store() {
+        close();
+    }
+
+    void history_store::open(const fc::path& dir) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FC_ASSERT(!_log.is_open(), "Operation history store is already open");
+
+        static_assert(sizeof(block_entry) == 16, "block_entry shouldn't be padded");
+        static_assert(sizeof(transaction_record) == 28, "transaction_record shouldn't be padded");
+        static_assert(sizeof(transaction_run) == 16, "transaction_run shouldn't be padded");
+
+        _dir = dir;
+        if (!fc::exists(dir)) {
+            fc::create_directories(dir);
+        }
+
+        auto log_path = dir / "operations.log";
+        auto index_path = dir / "operations.index";
+        auto transactions_path = dir / "transactions.index";
+        auto runs_path = dir / "transactions.runs";
+
+        open_file(_log, log_path);
+        open_file(_index, index_path);
+        open_file(_transactions, transactions_path);
+
+        // truncation on recovery doesn't affect descriptors
+        _log_fd = open_fd(log_path);
+        _index_fd = open_fd(index_path);
+        _transactions_fd = open_fd(transactions_path);
+
+        recover_blocks(index_path, log_path);
+        recover_transactions(runs_path, transactions_path);
+
+        ilog("Operation history store is open, blocks ${f}..${h}, ${r} transaction runs",
+            ("f", _first_block)("h", head())("r", _runs.size()));
+    }
+
+    void history_store::recover_blocks(const fc::path& index_path, const fc::path& log_path) {
+        _first_block = 0;
+        _block_count = 0;
+        _head_entry = block_entry();
+
+        uint64_t index_size = fc::file_size(index_path);
+        uint64_t log_size = fc::file_size(log_path);
+
+        if (index_size >= sizeof(uint64_t)) {
+            uint64_t first_block = 0;
+            _index.seekg(0);
+            _index.read(reinterpret_cast<char*>(&first_block), sizeof(first_block));
+            FC_ASSERT(_index.good(), "Can't read operation history index");
+
+            _first_block = static_cast<uint32_t>(first_block);
+            _block_count = static_cast<uint32_t>((index_size - sizeof(uint64_t)) / sizeof(block_entry));
+
+            // the index is written after the log, so entries of an interrupted append are dropped
+            while (_block_count > 0) {
+                _head_entry = read_entry(_first_block, head());
+                if (_head_entry.end_pos <= log_size) {
+                    break;
+                }
+                --_block_count;
+                _head_entry = block_entry();
+            }
+        }
+
+        if (_block_count == 0) {
+            _first_block = 0;
+            index_size = 0;
+        } else {
+            index_size = sizeof(uint64_t) + uint64_t(_block_count) * sizeof(block_entry);
+        }
+
+        _log.close();
+        _index.close();
+        boost::filesystem::resize_file(index_path.generic_string(), index_size);
+        boost::filesystem::resize_file(log_path.generic_string(), _head_entry.end_pos);
+        open_file(_log, log_path);
+        open_file(_index, index_path);
+    }
+
+    void history_store::recover_transactions(const fc::path& runs_path, const fc::path& transactions_path) {
+        _runs.clear();
+        _tail.clear();
+
+        uint64_t transactions_size = fc::file_size(transactions_path);
+
+        if (fc::exists(runs_path)) {
+            std::ifstream in(runs_path.generic_string(), std::ios::in | std::ios::binary);
+            transaction_run run;
+            while (in.read(reinterpret_cast<char*>(&run), sizeof(run))) {
+                // runs are listed after they are written, but the store can be truncated on recovery of blocks
+                if (run.pos + uint64_t(run.count) * sizeof(transaction_record) > transactions_size ||
+                    run.last_block > head()
+                ) {
+                    break;
+                }
+                _runs.push_back(run);
+            }
+        }
+
+        uint64_t runs_end = 0;
+        if (!_runs.empty()) {
+            runs_end = _runs.back().pos + uint64_t(_runs.back().count) * sizeof(transaction_record);
+        }
+        _transactions.close();
+        boost::filesystem::resize_file(transactions_path.generic_string(), runs_end);
+        open_file(_transactions, transactions_path);
+        write_runs();
+
+        if (_block_count == 0) {
+            return;
+        }
+
+        uint32_t block_num = _runs.empty() ? _first_block : std::max(_first_block, _runs.back().last_block + 1);
+        for (; block_num <= head(); ++block_num) {
+            add_transactions(block_num, read_block(_first_block, block_num));
+        }
+    }
+
+    void history_store::close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_log.is_open()) {
+            return;
+        }
+
+        _log.close();
+        _index.close();
+        _transactions.close();
+        close_fd(_log_fd);
+        close_fd(_index_fd);
+        close_fd(_transactions_fd);
+
+        _first_block = 0;
+        _block_count = 0;
+        _head_entry = block_entry();
+        _runs.clear();
+        _published_runs.reset();
+        _tail.clear();
+    }
+
+    bool history_store::is_open() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _log.is_open();
+    }
+
+    uint32_t history_store::head() const {
+        return _block_count ? _first_block + _block_count - 1 : 0;
+    }
+
+    uint32_t history_store::head_block_num() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return head();
+    }
+
+    void history_store::append_block(uint32_t block_num, const std::vector<stored_operation>& ops) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FC_ASSERT(_log.is_open(), "Operation history store isn't open");
+
+        if (block_num <= head()) {
+            return;
+        }
+
+        std::vector<block_entry> entries;
+        if (_block_count == 0) {
+            _first_block = block_num;
+
+            uint64_t first_block = block_num;
+            _index.seekp(0);
+            _index.write(reinterpret_cast<const char*>(&first_block), sizeof(first_block));
+        } else {
+            // blocks without stored operations
+            entries.assign(block_num - head() - 1, _head_entry);
+        }
+
+        auto entry = _head_entry;
+        if (!ops.empty()) {
+            auto data = fc::raw::pack(ops);
+            _log.seekp(entry.end_pos);
+            _log.write(data.data(), data.size());
+            _log.flush();
+            FC_ASSERT(_log.good(), "Can't write operation history log");
+
+            entry.end_pos += data.size();
+            for (const auto& op : ops) {
+                entry.end_id = std::max(entry.end_id, op.id + 1);
+            }
+        }
+        entries.push_back(entry);
+
+        _index.seekp(sizeof(uint64_t) + uint64_t(_block_count) * sizeof(block_entry));
+        _index.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(block_entry));
+        _index.flush();
+        FC_ASSERT(_index.good(), "Can't write operation history index");
+
+        _block_count += entries.size();
+        _head_entry = entry;
+
+        add_transactions(block_num, ops);
+        if (_tail.size() >= transactions_per_run) {
+            write_transaction_run(block_num);
+        }
+    }
+
+    history_store::block_entry history_store::read_entry(uint32_t first_block, uint32_t block_num) const {
+        block_entry entry;
+        read_at(_index_fd, sizeof(uint64_t) + uint64_t(block_num - first_block) * sizeof(block_entry),
+            reinterpret_cast<char*>(&entry), sizeof(entry));
+        return entry;
+    }
+
+    std::vector<stored_operation> history_store::read_block(uint32_t first_block, uint32_t block_num) const {
+        uint64_t begin = (block_num == first_block) ? 0 : read_entry(first_block, block_num - 1).end_pos;
+        uint64_t end = read_entry(first_block, block_num).end_pos;
+
+        if (begin == end) {
+            return {};
+        }
+
+        std::vector<char> data(end - begin);
+        read_at(_log_fd, begin, data.data(), data.size());
+
+        return fc::raw::unpack<std::vector<stored_operation>>(data);
+    }
+
+    std::vector<applied_operation> history_store::get_ops_in_block(uint32_t block_num) const {
+        uint32_t first_block;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_block_count == 0 || block_num < _first_block || block_num > head()) {
+                return {};
+            }
+            first_block = _first_block;
+        }
+
+        auto ops = read_block(first_block, block_num);
+
+        std::vector<applied_operation> result;
+        result.reserve(ops.size());
+        for (auto& op : ops) {
+            result.push_back(std::move(op.op));
+        }
+        return result;
+    }
+
+    fc::optional<applied_operation> history_store::find_operation(uint64_t id) const {
+        uint32_t first_block;
+        uint32_t head_block;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_block_count == 0 || id >= _head_entry.end_id) {
+                return {};
+            }
+            first_block = _first_block;
+            head_block = head();
+        }
+
+        // the first block which end id is greater than id
+        uint32_t low = first_block;
+        uint32_t high = head_block;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (read_entry(first_block, middle).end_id > id) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+
+        for (auto& op : read_block(first_block, low)) {
+            if (op.id == id) {
+                return std::move(op.op);
+            }
+        }
+        return {};
+    }
+
+    fc::optional<transaction_location> history_store::find_transaction(const protocol::transaction_id_type& id) const {
+        std::shared_ptr<const std::vector<transaction_run>> runs;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto itr = _tail.find(id);
+            if (itr != _tail.end()) {
+                return itr->second;
+            }
+            runs = _published_runs;
+        }
+        if (!runs) {
+            return {};
+        }
+
+        for (auto run = runs->rbegin(); run != runs->rend(); ++run) {
+            uint32_t low = 0;
+            uint32_t high = run->count;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                if (read_record(*run, middle).trx_id < id) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+
+            if (low < run->count) {
+                auto record = read_record(*run, low);
+                if (record.trx_id == id) {
+                    return transaction_location{record.block, record.trx_in_block};
+                }
+            }
+        }
+        return {};
+    }
+
+    history_store::transaction_record history_store::read_record(const transaction_run& run, uint32_t idx) const {
+        transaction_record record;
+        read_at(_transactions_fd, run.pos + uint64_t(idx) * sizeof(transaction_record),
+            reinterpret_cast<char*>(&record), sizeof(record));
+        return record;
+    }
+
+    void history_store::add_transactions(uint32_t block_num, const std::vector<stored_operation>& ops) {
+        for (const auto& op : ops) {
+            // virtual operations of the block don't belong to transactions
+            if (op.op.trx_id != protocol::transaction_id_type()) {
+                _tail.emplace(op.op.trx_id, transaction_location{block_num, op.op.trx_in_block});
+            }
+        }
+    }
+
+    void history_store::write_transaction_run(uint32_t last_block) {
+        std::vector<transaction_record> records;
+        records.reserve(_tail.size());
+        for (const auto& item : _tail) {
+            records.push_back(transaction_record{item.first, item.second.block, item.second.trx_in_block});
+        }
+        std::sort(records.begin(), records.end(), [](const transaction_record& a, const transaction_record& b) {
+            return a.trx_id < b.trx_id;
+        });
+
+        transaction_run run;
+        if (!_runs.empty()) {
+            run.pos = _runs.back().pos + uint64_t(_runs.back().count) * sizeof(transaction_record);
+        }
+        run.count = static_cast<uint32_t>(records.size());
+        run.last_block = last_block;
+
+        _transactions.seekp(run.pos);
+        _transactions.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(transaction_record));
+        _transactions.flush();
+        FC_ASSERT(_transactions.good(), "Can't write operation history transactions");
+
+        _runs.push_back(run);
+        write_runs();
+        _tail.clear();
+    }
+
+    void history_store::write_runs() {
+        // the list of runs is replaced at once, so it never refers to a partially written run
+        auto path = _dir / "transactions.runs";
+        auto tmp_path = _dir / "transactions.runs.tmp";
+        {
+            std::ofstream out(tmp_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(_runs.data()), _runs.size() * sizeof(transaction_run));
+            out.flush();
+            FC_ASSERT(out.good(), "Can't write ${p}", ("p", tmp_path));
+        }
+        fc::rename(tmp_path, path);
+
+        _published_runs = std::make_shared<const std::vector<transaction_run>>(_runs);
+    }
+
+} } } // graphene::plugins::operation_history
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <graphene/plugins/operation_history/applied_operation.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace operation_history {
+
+    /**
+     * Operation with the id of its operation_object, account_history refers to operations by ids
+     */
+    struct stored_operation final {
+        uint64_t id = 0;
+        applied_operation op;
+    };
+
+    struct transaction_location final {
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+    };
+
+    /**
+     * Append-only store of operations of irreversible blocks.
+     *
+     * operations.log contains operations of blocks one after another, each block is a packed vector
+     * of stored_operation in the order of by_location.
+     *
+     * operations.index starts with the number of the first stored block, it's followed by an entry
+     * per block: the end position of the block in operations.log and the greatest id of stored operations
+     * up to the block (plus one). Blocks without operations have empty entries, so a block is found in O(1),
+     * and an operation is found by the binary search of ids.
+     *
+     * transactions.index contains sorted runs of (trx_id, block, trx_in_block) records, transactions.runs lists
+     * them. Transactions of blocks after the last run are kept in memory until they fill the next run,
+     * on open they are collected again from operations.log.
+     *
+     * Appending is called under the write lock of the database, reading is called under the read lock.
+     * Stored data isn't changed after append, so readers take the head of the store under the mutex
+     * and read files by positional reads without locking, only transactions after the last run are read under it.
+     */
+    class history_store final {
+    public:
+        history_store() = default;
+
+        ~history_store();
+
+        void open(const fc::path& dir);
+
+        void close();
+
+        bool is_open() const;
+
+        /**
+         * Returns the last stored block, or 0 if the store is empty
+         */
+        uint32_t head_block_num() const;
+
+        /**
+         * Appends operations of the block, blocks up to the head are ignored
+         */
+        void append_block(uint32_t block_num, const std::vector<stored_operation>& ops);
+
+        std::vector<applied_operation> get_ops_in_block(uint32_t block_num) const;
+
+        fc::optional<applied_operation> find_operation(uint64_t id) const;
+
+        fc::optional<transaction_location> find_transaction(const protocol::transaction_id_type& id) const;
+
+    private:
+        struct block_entry {
+            uint64_t end_pos = 0;
+            uint64_t end_id = 0;
+        };
+
+        struct transaction_record {
+            protocol::transaction_id_type trx_id;
+            uint32_t block = 0;
+            uint32_t trx_in_block = 0;
+        };
+
+        struct transaction_run {
+            uint64_t pos = 0;
+            uint32_t count = 0;
+            uint32_t last_block = 0;
+        };
+
+        struct transaction_id_hash {
+            std::size_t operator()(const protocol::transaction_id_type& id) const {
+                return (std::size_t(id._hash[0]) << 32) | id._hash[1];
+            }
+        };
+
+        static constexpr uint32_t transactions_per_run = 1 << 18;
+
+        uint32_t head() const;
+
+        void recover_blocks(const fc::path& index_path, const fc::path& log_path);
+
+        void recover_transactions(const fc::path& runs_path, const fc::path& transactions_path);
+
+        block_entry read_entry(uint32_t first_block, uint32_t block_num) const;
+
+        std::vector<stored_operation> read_block(uint32_t first_block, uint32_t block_num) const;
+
+        transaction_record read_record(const transaction_run& run, uint32_t idx) const;
+
+        void add_transactions(uint32_t block_num, const std::vector<stored_operation>& ops);
+
+        void write_transaction_run(uint32_t last_block);
+
+        void write_runs();
+
+        fc::path _dir;
+        std::fstream _log;
+        std::fstream _index;
+        std::fstream _transactions;
+        mutable std::mutex _mutex;
+
+        // descriptors for positional reads
+        int _log_fd = -1;
+        int _index_fd = -1;
+        int _transactions_fd = -1;
+
+        uint32_t _first_block = 0;
+        uint32_t _block_count = 0;
+        block_entry _head_entry;
+
+        std::vector<transaction_run> _runs;
+        std::shared_ptr<const std::vector<transaction_run>> _published_runs; // the copy of _runs for readers
+        std::unordered_map<protocol::transaction_id_type, transaction_location, transaction_id_hash> _tail;
+    };
+
+} } } // graphene::plugins::operation_history
+
+FC_REFLECT(
+    (graphene::plugins::operation_history::stored_operation),
+    (id)(op))
+
+FC_REFLECT(
+    (graphene::plugins::operation_history::transaction_location),
+    (block)(trx_in_block))
@@ -69,6 +69,11 @@ namespace graphene { namespace plugins { namespace operation_history {
         void plugin_startup() override;
         void plugin_shutdown() override;
 
+        /**
+         * Returns the operation from the shared memory or from the disk store, should be called under the read lock
+         */
+        applied_operation get_operation(operation_id_type id) const;
+
         DECLARE_API(
             /**
              *  @brief Get sequence of operations included/generated within a particular block
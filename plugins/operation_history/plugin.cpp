@@ -1,10 +1,13 @@
 #include <graphene/plugins/operation_history/plugin.hpp>
 #include <graphene/plugins/operation_history/history_object.hpp>
+#include <graphene/plugins/operation_history/history_store.hpp>
 
 #include <graphene/chain/operation_notification.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+
 #define NAMESPACE_PREFIX "graphene::protocol::"
 
 #define CHECK_ARG_SIZE(s) \
@@ -96,19 +99,73 @@ namespace graphene { namespace plugins { namespace operation_history {
 
         ~plugin_impl() = default;
 
+        // purging runs once per purge_interval blocks and removes whole blocks up to purge_limit operations,
+        //   the rest is removed on next blocks
         void purge_old_history(){
             uint32_t head_block = database.head_block_num();
-            //ilog("operation_history: purge_old_history START ${c} <= ${h}", ("c",history_count_blocks)("h", head_block));
-            if (history_count_blocks <= head_block) {
-                uint32_t need_block = head_block - history_count_blocks;
-                const auto& idx = database.get_index<operation_index>().indices().get<by_block>();
-                auto it = idx.begin();
-                while (it != idx.end() && it->block <= need_block) {
-                    auto next_it = it;
-                    ++next_it;
-                    //ilog("operation_history: REMOVE ${c}", ("c",it->block));
-                    database.remove(*it);
-                    it = next_it;
+            if (history_count_blocks > head_block) {
+                return;
+            }
+            if (!purge_pending && head_block < last_purge_block + purge_interval) {
+                return;
+            }
+            last_purge_block = head_block;
+
+            auto start = fc::time_point::now();
+            uint32_t need_block = head_block - history_count_blocks;
+            const auto& idx = database.get_index<operation_index>().indices().get<by_block>();
+            auto it = idx.begin();
+            uint32_t count = 0;
+            uint32_t last_block = 0;
+            while (it != idx.end() && it->block <= need_block && (count < purge_limit || it->block == last_block)) {
+                auto next_it = it;
+                ++next_it;
+                last_block = it->block;
+                database.remove(*it);
+                ++count;
+                it = next_it;
+            }
+            purge_pending = (it != idx.end() && it->block <= need_block);
+
+            if (count) {
+                auto elapsed = (fc::time_point::now() - start).count() / 1000;
+                if (elapsed >= 50) {
+                    wlog("operation_history: purge of ${c} operations up to block ${b} took ${t} ms",
+                        ("c", count)("b", last_block)("t", elapsed));
+                } else {
+                    dlog("operation_history: purge of ${c} operations up to block ${b} took ${t} ms",
+                        ("c", count)("b", last_block)("t", elapsed));
+                }
+            }
+        }
+
+        // operations of irreversible blocks are moved from the shared memory to the disk store
+        void move_irreversible_history() {
+            uint32_t last_irreversible_block = database.last_non_undoable_block_num();
+            uint32_t store_head_block = store.head_block_num();
+
+            const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
+            auto it = idx.begin();
+
+            std::vector<const operation_object*> objects;
+            std::vector<stored_operation> ops;
+            while (it != idx.end() && it->block <= last_irreversible_block) {
+                uint32_t block = it->block;
+                objects.clear();
+                ops.clear();
+                for (; it != idx.end() && it->block == block; ++it) {
+                    objects.push_back(&*it);
+                    // blocks up to the head of the store are applied again on replay
+                    if (block > store_head_block) {
+                        ops.push_back(stored_operation{static_cast<uint64_t>(it->id._id), applied_operation(*it)});
+                    }
+                }
+
+                if (block > store_head_block) {
+                    store.append_block(block, ops);
+                }
+                for (auto obj : objects) {
+                    database.remove(*obj);
                 }
             }
         }
@@ -125,6 +182,18 @@ namespace graphene { namespace plugins { namespace operation_history {
             uint32_t block_num,
             bool only_virtual
         ) {
+            if (store_to_disk && block_num <= store.head_block_num()) {
+                auto result = store.get_ops_in_block(block_num);
+                if (only_virtual) {
+                    result.erase(
+                        std::remove_if(result.begin(), result.end(), [](const applied_operation& operation) {
+                            return operation.virtual_op == 0;
+                        }),
+                        result.end());
+                }
+                return result;
+            }
+
             const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
             auto itr = idx.lower_bound(block_num);
             std::vector<applied_operation> result;
@@ -138,25 +207,52 @@ namespace graphene { namespace plugins { namespace operation_history {
         }
 
         annotated_signed_transaction get_transaction(transaction_id_type id) {
+            fc::optional<transaction_location> location;
+
             const auto &idx = database.get_index<operation_index>().indices().get<by_transaction_id>();
             auto itr = idx.lower_bound(id);
             if (itr != idx.end() && itr->trx_id == id) {
-                auto blk = database.fetch_block_by_number(itr->block);
-                FC_ASSERT(blk.valid());
-                FC_ASSERT(blk->transactions.size() > itr->trx_in_block);
-                annotated_signed_transaction result = blk->transactions[itr->trx_in_block];
-                result.block_num = itr->block;
-                result.transaction_num = itr->trx_in_block;
-                return result;
+                location = transaction_location{itr->block, itr->trx_in_block};
+            } else if (store_to_disk) {
+                location = store.find_transaction(id);
             }
-            FC_ASSERT(false, "Unknown Transaction ${t}", ("t", id));
+            FC_ASSERT(location.valid(), "Unknown Transaction ${t}", ("t", id));
+
+            auto blk = database.fetch_block_by_number(location->block);
+            FC_ASSERT(blk.valid());
+            FC_ASSERT(blk->transactions.size() > location->trx_in_block);
+            annotated_signed_transaction result = blk->transactions[location->trx_in_block];
+            result.block_num = location->block;
+            result.transaction_num = location->trx_in_block;
+            return result;
+        }
+
+        applied_operation get_operation(operation_id_type id) {
+            const auto* obj = database.find<operation_object, by_id>(id);
+            if (obj != nullptr) {
+                return applied_operation(*obj);
+            }
+
+            if (store_to_disk) {
+                auto operation = store.find_operation(id._id);
+                if (operation.valid()) {
+                    return *operation;
+                }
+            }
+            FC_ASSERT(false, "Unknown operation ${id}", ("id", id));
         }
 
         bool filter_content = false;
         uint32_t start_block = 0;
         uint32_t history_count_blocks = UINT32_MAX;
+        uint32_t purge_interval = 1;
+        uint32_t purge_limit = UINT32_MAX;
+        uint32_t last_purge_block = 0;
+        bool purge_pending = false;
         bool blacklist = false;
         fc::flat_set<std::string> ops_list;
+        bool store_to_disk = false;
+        history_store store;
         graphene::chain::database& database;
     };
 
@@ -177,6 +273,10 @@ namespace graphene { namespace plugins { namespace operation_history {
         });
     }
 
+    applied_operation plugin::get_operation(operation_id_type id) const {
+        return pimpl->get_operation(id);
+    }
+
     void plugin::set_program_options(
         boost::program_options::options_description& cli,
         boost::program_options::options_description& cfg
@@ -197,6 +297,18 @@ namespace graphene { namespace plugins { namespace operation_history {
             "history-count-blocks",
             boost::program_options::value<uint32_t>(),
             "Defines depth of history for recording stats."
+        ) (
+            "history-purge-interval",
+            boost::program_options::value<uint32_t>()->default_value(100),
+            "Defines the number of blocks between purges of history, which is older than history-count-blocks."
+        ) (
+            "history-purge-limit",
+            boost::program_options::value<uint32_t>()->default_value(20000),
+            "Defines the number of history objects removed by one purge, the rest is removed on next blocks."
+        ) (
+            "history-store",
+            boost::program_options::value<std::string>()->default_value("shared_memory"),
+            "Defines where operations of irreversible blocks are stored: shared_memory or disk."
         );
         cfg.add(cli);
     }
@@ -251,16 +363,50 @@ namespace graphene { namespace plugins { namespace operation_history {
         if (options.count("history-count-blocks")) {
             uint32_t history_count_blocks = options.at("history-count-blocks").as<uint32_t>();
             pimpl->history_count_blocks = history_count_blocks;
+            pimpl->purge_interval = std::max<uint32_t>(options.at("history-purge-interval").as<uint32_t>(), 1);
+            pimpl->purge_limit = std::max<uint32_t>(options.at("history-purge-limit").as<uint32_t>(), 1);
             pimpl->database.applied_block.connect([&](const signed_block& block){
                 pimpl->purge_old_history();
             });
+            ilog("operation_history: history-purge-interval ${i}, history-purge-limit ${l}",
+                ("i", pimpl->purge_interval)("l", pimpl->purge_limit));
         } else {
             pimpl->history_count_blocks = UINT32_MAX;
         }
         ilog("operation_history: history-count-blocks ${s}", ("s", pimpl->history_count_blocks));
 
+        auto store_type = options.at("history-store").as<std::string>();
+        if (store_type == "disk") {
+            FC_ASSERT(
+                !options.count("history-count-blocks"),
+                "history-count-blocks can't be used with history-store = disk");
+
+            // the store is opened before the replay, which is started by the chain plugin
+            pimpl->store_to_disk = true;
+            pimpl->store.open(appbase::app().data_dir() / "blockchain" / "operation_history");
+            pimpl->database.applied_block.connect([&](const signed_block& block){
+                pimpl->move_irreversible_history();
+            });
+        } else {
+            FC_ASSERT(store_type == "shared_memory", "Unknown history-store ${s}", ("s", store_type));
+        }
+        ilog("operation_history: history-store ${s}", ("s", store_type));
+
 
         JSON_RPC_REGISTER_API(name());
+
+        // operations of irreversible blocks don't change, unless they are purged by history-count-blocks
+        auto& chain = appbase::app().get_plugin<chain::plugin>();
+        bool purged = options.count("history-count-blocks") != 0;
+        appbase::app().get_plugin<json_rpc::plugin>().add_cache_policy(name(), "get_ops_in_block",
+            [&chain, purged](const json_rpc::msg_pack& args) {
+                auto block_num = args.args->at(0).as<uint32_t>();
+                if (!purged && block_num <= chain.last_irreversible_block_num()) {
+                    return json_rpc::plugin::cache_scope::immutable;
+                }
+                return json_rpc::plugin::cache_scope::head;
+            });
+
         ilog("operation_history plugin: plugin_initialize() end");
     }
 
@@ -279,6 +425,7 @@ namespace graphene { namespace plugins { namespace operation_history {
     }
 
     void plugin::plugin_shutdown() {
+        pimpl->store.close();
     }
 
 } } } // graphene::plugins::operation_history
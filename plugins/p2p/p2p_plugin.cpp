@@ -30,6 +30,7 @@ namespace graphene {
             using graphene::protocol::block_header;
             using graphene::protocol::signed_block_header;
             using graphene::protocol::signed_block;
+            using graphene::protocol::signed_transaction;
             using graphene::protocol::block_id_type;
             using graphene::chain::database;
             using graphene::chain::chain_id_type;
@@ -65,6 +66,8 @@ namespace graphene {
 
                     virtual message get_item(const item_id &) override;
 
+                    virtual std::vector<signed_transaction> get_pending_transactions() override;
+
                     virtual std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t &, uint32_t) override;
 
                     virtual void sync_status(uint32_t, uint32_t) override;
@@ -92,6 +95,7 @@ namespace graphene {
                     vector<fc::ip::endpoint> seeds;
                     string user_agent;
                     uint32_t max_connections = 0;
+                    fc::optional<uint32_t> decode_threads;
                     bool force_validate = false;
                     bool block_producer = false;
 
@@ -259,16 +263,26 @@ namespace graphene {
                 message p2p_plugin_impl::get_item(const item_id &id) {
                     try {
                         if (id.item_type == network::block_message_type) {
-                            return chain.db().with_weak_read_lock([&]() {
-                                auto opt_block = chain.db().fetch_block_by_id(id.item_hash);
+                            auto raw_block = chain.db().with_weak_read_lock([&]() {
+                                auto opt_block = chain.db().fetch_raw_block_by_id(id.item_hash);
                                 if (!opt_block)
                                     elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                                          ("id", id.item_hash)("id2", chain.db().get_block_id_for_num(
                                                  block_header::num_from_id(id.item_hash))));
-                                FC_ASSERT(opt_block.valid());
-                                // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-                                return block_message(std::move(*opt_block));
+                                return opt_block;
                             });
+                            FC_ASSERT(raw_block.valid());
+                            // ilog("Serving up block #${num}", ("num", block_header::num_from_id(id.item_hash)));
+
+                            // block_message is the serialized block followed by its id,
+                            //   so the stored block is sent without unpacking and packing again
+                            const block_id_type block_id(id.item_hash);
+                            std::vector<char> data;
+                            data.reserve(raw_block->size + fc::raw::pack_size(block_id));
+                            data.insert(data.end(), raw_block->data, raw_block->data + raw_block->size);
+                            auto packed_id = fc::raw::pack(block_id);
+                            data.insert(data.end(), packed_id.begin(), packed_id.end());
+                            return message(block_message::type, std::move(data));
                         }
                         return chain.db().with_weak_read_lock([&]() {
                             return trx_message(chain.db().get_recent_transaction(id.item_hash));
@@ -276,6 +290,17 @@ namespace graphene {
                     } FC_CAPTURE_AND_RETHROW((id))
                 }
 
+                std::vector<signed_transaction> p2p_plugin_impl::get_pending_transactions() {
+                    return chain.db().with_weak_read_lock([&]() {
+                        std::vector<signed_transaction> result;
+                        result.reserve(chain.db()._pending_tx.size());
+                        for (const auto &trx : chain.db()._pending_tx) {
+                            result.push_back(trx.transaction());
+                        }
+                        return result;
+                    });
+                }
+
                 chain_id_type p2p_plugin_impl::get_chain_id() const {
                     return CHAIN_ID;
                 }
@@ -413,6 +438,17 @@ namespace graphene {
                 fc::time_point_sec p2p_plugin_impl::get_block_time(const item_hash_t &block_id) {
                     try {
                         return chain.db().with_weak_read_lock([&]() {
+                            // only the header of a block from the block log is unpacked
+                            const auto &block_log = chain.db().get_block_log();
+                            if (block_header::num_from_id(block_id) <= block_log.head_block_num()) {
+                                auto raw_block = block_log.read_raw_block_by_num(block_header::num_from_id(block_id));
+                                if (raw_block.valid()) {
+                                    auto header = raw_block->header();
+                                    if (header.id() == block_id) {
+                                        return header.timestamp;
+                                    }
+                                }
+                            }
                             auto opt_block = chain.db().fetch_block_by_id(block_id);
                             if (opt_block.valid()) {
                                 return opt_block->timestamp;
@@ -470,6 +506,8 @@ namespace graphene {
                         "The local IP address and port to listen for incoming connections.")
                     ("p2p-max-connections", boost::program_options::value<uint32_t>(),
                         "Maxmimum number of incoming connections on P2P endpoint.")
+                    ("p2p-decode-threads", boost::program_options::value<uint32_t>(),
+                        "Number of threads which unpack and hash blocks received from peers (0 to do it on the P2P thread).")
                     ("seed-node", boost::program_options::value<vector<string>>()->composing(),
                         "The IP address and port of a remote peer to sync with. Deprecated in favor of p2p-seed-node.")
                     ("p2p-seed-node", boost::program_options::value<vector<string>>()->composing(),
@@ -494,6 +532,10 @@ namespace graphene {
                     my->max_connections = options.at("p2p-max-connections").as<uint32_t>();
                 }
 
+                if (options.count("p2p-decode-threads")) {
+                    my->decode_threads = options.at("p2p-decode-threads").as<uint32_t>();
+                }
+
                 if (options.count("seed-node") || options.count("p2p-seed-node")) {
                     vector<string> seeds;
                     if (options.count("seed-node")) {
@@ -552,6 +594,13 @@ namespace graphene {
                         my->node->set_advanced_node_parameters(node_param);
                     }
 
+                    if (my->decode_threads) {
+                        ilog("Setting p2p decode threads to ${n}", ("n", *my->decode_threads));
+                        fc::variant_object node_param = fc::variant_object("number_of_decode_threads",
+                                                                           fc::variant(*my->decode_threads));
+                        my->node->set_advanced_node_parameters(node_param);
+                    }
+
                     my->node->listen_to_p2p_network();
                     my->node->connect_to_p2p_network();
                     block_id_type block_id;
@@ -22,6 +22,7 @@ struct get_raw_block_r {
 };
 
 DEFINE_API_ARGS ( get_raw_block, msg_pack, get_raw_block_r )
+DEFINE_API_ARGS ( get_raw_blocks, msg_pack, std::vector<get_raw_block_r> )
 
 using boost::program_options::options_description;
 
@@ -56,6 +57,7 @@ public:
 
     DECLARE_API (
         (get_raw_block)
+        (get_raw_blocks)
     )
 
 private:
@@ -3,11 +3,15 @@
 #include <graphene/protocol/types.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
 #include <graphene/plugins/json_rpc/plugin.hpp>
+#include <fc/crypto/base64.hpp>
 
 namespace graphene {
 namespace plugins {
 namespace raw_block {
 
+// limit of blocks in one get_raw_blocks request
+static constexpr uint32_t max_raw_blocks_count = 1000;
+
 struct plugin::plugin_impl {
 public:
     plugin_impl() : db_(appbase::app().get_plugin<plugins::chain::plugin>().db()) {
@@ -19,29 +23,33 @@ public:
     graphene::chain::database &database() {
         return db_;
     }
+
+    static get_raw_block_r make_raw_block(const graphene::chain::raw_block_view &raw);
 private:
     graphene::chain::database & db_;
 };
 
-get_raw_block_r plugin::plugin_impl::get_raw_block(uint32_t block_num) {
+get_raw_block_r plugin::plugin_impl::make_raw_block(const graphene::chain::raw_block_view &raw) {
     get_raw_block_r result;
+    // the block is sent as it's stored, only the header is unpacked
+    auto header = raw.header();
+    result.raw_block = fc::base64_encode(
+        reinterpret_cast<const unsigned char *>(raw.data),
+        static_cast<unsigned int>(raw.size));
+    result.block_id = header.id();
+    result.previous = header.previous;
+    result.timestamp = header.timestamp;
+    return result;
+}
+
+get_raw_block_r plugin::plugin_impl::get_raw_block(uint32_t block_num) {
     const auto &db = database();
 
-    auto block = db.fetch_block_by_number(block_num);
-    if (!block.valid()) {
-        return result;
+    auto raw = db.fetch_raw_block_by_number(block_num);
+    if (!raw.valid()) {
+        return get_raw_block_r();
     }
-    std::vector<char> serialized_block = fc::raw::pack(*block);
-    result.raw_block = fc::base64_encode(
-        std::string(
-            &serialized_block[0],
-            &serialized_block[0] + serialized_block.size()
-        )
-    );
-    result.block_id = block->id();
-    result.previous = block->previous;
-    result.timestamp = block->timestamp;
-    return result;
+    return make_raw_block(*raw);
 }
 
 DEFINE_API ( plugin, get_raw_block ) {
@@ -52,6 +60,26 @@ DEFINE_API ( plugin, get_raw_block ) {
     });
 }
 
+DEFINE_API ( plugin, get_raw_blocks ) {
+    FC_ASSERT(args.args->size() == 2, "Expected 2 arguments, was ${n}", ("n", args.args->size()));
+    auto block_num = args.args->at(0).as<uint32_t>();
+    auto count = args.args->at(1).as<uint32_t>();
+    FC_ASSERT(count <= max_raw_blocks_count, "count should be less or equal to ${m}", ("m", max_raw_blocks_count));
+
+    auto &db = my->database();
+    auto raw_blocks = db.with_weak_read_lock([&]() {
+        return db.fetch_raw_blocks(block_num, count);
+    });
+
+    // blocks are encoded without the lock, views keep their data
+    std::vector<get_raw_block_r> result;
+    result.reserve(raw_blocks.size());
+    for (const auto &raw: raw_blocks) {
+        result.push_back(plugin_impl::make_raw_block(raw));
+    }
+    return result;
+}
+
 plugin::plugin() {
 }
 
@@ -405,4 +405,18 @@ CHAINBASE_SET_INDEX_TYPE(
     graphene::plugins::tags::language_index)
 
 FC_REFLECT((graphene::plugins::tags::content_metadata), (tags)(language))
+FC_REFLECT_ENUM(graphene::plugins::tags::tag_type, (tag)(language))
+
+FC_REFLECT((graphene::plugins::tags::tag_object),
+    (id)(name)(type)(created)(active)(updated)(cashout)(net_rshares)(net_votes)(children)(hot)(trending)
+    (children_rshares)(author)(parent)(content))
+
+FC_REFLECT((graphene::plugins::tags::tag_stats_object),
+    (id)(name)(type)(total_children_rshares)(total_payout)(net_votes)(top_posts)(contents))
+
+FC_REFLECT((graphene::plugins::tags::author_tag_stats_object),
+    (id)(author)(name)(type)(total_rewards)(total_posts))
+
+FC_REFLECT((graphene::plugins::tags::language_object), (id)(name))
+
 
@@ -7,6 +7,7 @@
 #include <fc/io/json.hpp>
 #include <fc/network/resolve.hpp>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
 #include <boost/bind.hpp>
@@ -20,9 +21,16 @@
 #include <websocketpp/logger/stub.hpp>
 #include <websocketpp/logger/syslog.hpp>
 
+#ifdef WEBSERVER_COMPRESSION
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#include <zlib.h>
+#endif
+
+#include <cstring>
 #include <thread>
 #include <memory>
 #include <iostream>
+#include <sstream>
 #include <graphene/plugins/json_rpc/plugin.hpp>
 
 namespace graphene {
@@ -71,18 +79,90 @@ namespace graphene {
 
                 typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
 
+#ifdef WEBSERVER_COMPRESSION
+                // messages are compressed, if clients offer the extension
+                struct permessage_deflate_config {};
+
+                typedef websocketpp::extensions::permessage_deflate::enabled<permessage_deflate_config>
+                    permessage_deflate_type;
+#endif
+
                 static const long timeout_open_handshake = 0;
             };
 
+            enum class content_encoding {
+                identity,
+                gzip,
+                deflate
+            };
+
+            // Returns the first encoding of Accept-Encoding, which is supported and isn't refused with q=0
+            static content_encoding select_encoding(const std::string &accept_encoding) {
+                std::vector<std::string> items;
+                boost::split(items, accept_encoding, boost::is_any_of(","));
+
+                for (auto &item: items) {
+                    std::vector<std::string> params;
+                    boost::split(params, item, boost::is_any_of(";"));
+
+                    auto name = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(params[0]));
+                    bool refused = false;
+                    for (std::size_t i = 1; i < params.size(); ++i) {
+                        auto param = boost::algorithm::erase_all_copy(params[i], " ");
+                        if (param == "q=0" || param == "q=0.0" || param == "q=0.00" || param == "q=0.000") {
+                            refused = true;
+                        }
+                    }
+
+                    if (refused) {
+                        continue;
+                    } else if (name == "gzip") {
+                        return content_encoding::gzip;
+                    } else if (name == "deflate") {
+                        return content_encoding::deflate;
+                    }
+                }
+                return content_encoding::identity;
+            }
+
+#ifdef WEBSERVER_COMPRESSION
+            static bool compress_body(const std::string &body, content_encoding encoding, std::string &result) {
+                z_stream stream;
+                std::memset(&stream, 0, sizeof(stream));
+
+                // window bits of gzip have the 16 flag, deflate of http is the zlib format
+                int window_bits = (encoding == content_encoding::gzip) ? 15 + 16 : 15;
+                if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    return false;
+                }
+
+                result.resize(deflateBound(&stream, body.size()));
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+                stream.avail_in = body.size();
+                stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+                stream.avail_out = result.size();
+
+                auto status = deflate(&stream, Z_FINISH);
+                result.resize(stream.total_out);
+                deflateEnd(&stream);
+                return status == Z_STREAM_END;
+            }
+#endif
+
             using websocket_server_type = websocketpp::server<asio_with_stub_log>;
 
             struct webserver_plugin::webserver_plugin_impl final {
             public:
                 boost::thread_group& thread_pool = appbase::app().scheduler();
-                webserver_plugin_impl(thread_pool_size_t thread_pool_size) : thread_pool_work(this->thread_pool_ios) {
+                webserver_plugin_impl(thread_pool_size_t thread_pool_size, thread_pool_size_t heavy_thread_pool_size)
+                    : thread_pool_work(this->thread_pool_ios),
+                      heavy_thread_pool_work(this->heavy_thread_pool_ios) {
                     for (uint32_t i = 0; i < thread_pool_size; ++i) {
                         thread_pool.create_thread(boost::bind(&asio::io_service::run, &thread_pool_ios));
                     }
+                    for (uint32_t i = 0; i < heavy_thread_pool_size; ++i) {
+                        thread_pool.create_thread(boost::bind(&asio::io_service::run, &heavy_thread_pool_ios));
+                    }
                 }
 
                 void start_webserver();
@@ -93,6 +173,23 @@ namespace graphene {
 
                 void handle_http_message(websocket_server_type *, connection_hdl);
 
+                std::string render_metrics() const;
+
+                void send_http_body(
+                    const websocket_server_type::connection_ptr &con, const std::string &data, content_encoding encoding);
+
+                // calls of batch requests are run in the thread pool,
+                //   heavy calls are run in their own thread pool, so they can't block cheap calls
+                plugins::json_rpc::plugin::task_executor_type get_executor() {
+                    return [this](plugins::json_rpc::plugin::call_lane lane, std::function<void()> task) {
+                        if (lane == plugins::json_rpc::plugin::call_lane::heavy) {
+                            heavy_thread_pool_ios.post(std::move(task));
+                        } else {
+                            thread_pool_ios.post(std::move(task));
+                        }
+                    };
+                }
+
                 shared_ptr<std::thread> http_thread;
                 asio::io_service http_ios;
                 optional<tcp::endpoint> http_endpoint;
@@ -104,6 +201,13 @@ namespace graphene {
                 websocket_server_type ws_server;
                 asio::io_service thread_pool_ios;
                 asio::io_service::work thread_pool_work;
+                asio::io_service heavy_thread_pool_ios;
+                asio::io_service::work heavy_thread_pool_work;
+
+                optional<std::string> metrics_path;
+
+                // bodies of http responses from this size are compressed, 0 disables the compression
+                uint32_t compression_min_size = 0;
 
                 plugins::json_rpc::plugin *api;
                 boost::signals2::connection chain_sync_con;
@@ -174,6 +278,7 @@ namespace graphene {
                 }
 
                 thread_pool_ios.stop();
+                heavy_thread_pool_ios.stop();
                 thread_pool.join_all();
 
                 if (ws_thread) {
@@ -203,7 +308,7 @@ namespace graphene {
                                 if (ec) {
                                     throw websocketpp::exception(ec);
                                 }
-                            });
+                            }, get_executor());
                         } else {
                             con->send("error: string payload expected");
                         }
@@ -213,21 +318,122 @@ namespace graphene {
                 });
             }
 
+            // Statistics in the Prometheus text format
+            std::string webserver_plugin::webserver_plugin_impl::render_metrics() const {
+                std::ostringstream out;
+
+                auto write_summary = [&](
+                    const std::string &name, const std::string &method, const plugins::json_rpc::rpc_latency_stats &stats,
+                    uint64_t count
+                ) {
+                    auto labels = "method=\"" + method + "\"";
+                    out << name << '{' << labels << ",quantile=\"0.5\"} " << stats.p50 << '\n';
+                    out << name << '{' << labels << ",quantile=\"0.9\"} " << stats.p90 << '\n';
+                    out << name << '{' << labels << ",quantile=\"0.99\"} " << stats.p99 << '\n';
+                    out << name << "_sum{" << labels << "} " << stats.total << '\n';
+                    out << name << "_count{" << labels << "} " << count << '\n';
+                };
+
+                auto stats = api->get_stats();
+
+                out << "# TYPE vizd_rpc_calls_total counter\n";
+                for (const auto &item: stats) {
+                    out << "vizd_rpc_calls_total{method=\"" << item.method << "\"} " << item.calls << '\n';
+                }
+                out << "# TYPE vizd_rpc_errors_total counter\n";
+                for (const auto &item: stats) {
+                    out << "vizd_rpc_errors_total{method=\"" << item.method << "\"} " << item.errors << '\n';
+                }
+                out << "# TYPE vizd_rpc_bytes_out_total counter\n";
+                for (const auto &item: stats) {
+                    out << "vizd_rpc_bytes_out_total{method=\"" << item.method << "\"} " << item.bytes_out << '\n';
+                }
+                out << "# TYPE vizd_rpc_queue_wait_microseconds summary\n";
+                for (const auto &item: stats) {
+                    write_summary("vizd_rpc_queue_wait_microseconds", item.method, item.queue_wait, item.calls);
+                }
+                out << "# TYPE vizd_rpc_lock_wait_microseconds summary\n";
+                for (const auto &item: stats) {
+                    write_summary("vizd_rpc_lock_wait_microseconds", item.method, item.lock_wait, item.calls);
+                }
+                out << "# TYPE vizd_rpc_execution_microseconds summary\n";
+                for (const auto &item: stats) {
+                    write_summary("vizd_rpc_execution_microseconds", item.method, item.execution, item.calls);
+                }
+                out << "# TYPE vizd_rpc_serialization_microseconds summary\n";
+                for (const auto &item: stats) {
+                    write_summary("vizd_rpc_serialization_microseconds", item.method, item.serialization, item.calls);
+                }
+
+                auto chain = appbase::app().find_plugin<chain::plugin>();
+                if (chain != nullptr) {
+                    auto queue = chain->get_write_queue_stats();
+                    out << "# TYPE vizd_write_queue_block_depth gauge\n";
+                    out << "vizd_write_queue_block_depth " << queue.block_queue_depth << '\n';
+                    out << "# TYPE vizd_write_queue_transaction_depth gauge\n";
+                    out << "vizd_write_queue_transaction_depth " << queue.transaction_queue_depth << '\n';
+                    out << "# TYPE vizd_write_queue_pushed_blocks_total counter\n";
+                    out << "vizd_write_queue_pushed_blocks_total " << queue.pushed_blocks << '\n';
+                    out << "# TYPE vizd_write_queue_pushed_transactions_total counter\n";
+                    out << "vizd_write_queue_pushed_transactions_total " << queue.pushed_transactions << '\n';
+                    out << "# TYPE vizd_write_queue_block_wait_microseconds_total counter\n";
+                    out << "vizd_write_queue_block_wait_microseconds_total " << queue.total_block_wait << '\n';
+                    out << "# TYPE vizd_write_queue_transaction_wait_microseconds_total counter\n";
+                    out << "vizd_write_queue_transaction_wait_microseconds_total " << queue.total_transaction_wait << '\n';
+                }
+
+                return out.str();
+            }
+
+            void webserver_plugin::webserver_plugin_impl::send_http_body(
+                const websocket_server_type::connection_ptr &con, const std::string &data, content_encoding encoding
+            ) {
+#ifdef WEBSERVER_COMPRESSION
+                // the response is compressed in the thread, which completed the call
+                std::string compressed;
+                if (encoding != content_encoding::identity && data.size() >= compression_min_size &&
+                    compress_body(data, encoding, compressed)
+                ) {
+                    con->append_header("Content-Encoding", encoding == content_encoding::gzip ? "gzip" : "deflate");
+                    con->append_header("Vary", "Accept-Encoding");
+                    con->set_body(compressed);
+                } else {
+                    con->set_body(data);
+                }
+#else
+                con->set_body(data);
+#endif
+                con->set_status(websocketpp::http::status_code::ok);
+                con->send_http_response();
+            }
+
             void webserver_plugin::webserver_plugin_impl::handle_http_message(websocket_server_type *server, connection_hdl hdl) {
                 auto con = server->get_con_from_hdl(hdl);
+
+                if (metrics_path && con->get_request().get_method() == "GET" && con->get_resource() == *metrics_path) {
+                    // the response is sent after the return from the handler
+                    con->set_body(render_metrics());
+                    con->append_header("Content-Type", "text/plain; version=0.0.4");
+                    con->set_status(websocketpp::http::status_code::ok);
+                    return;
+                }
+
                 con->defer_http_response();
 
                 thread_pool_ios.post([con, this]() {
                     auto body = con->get_request_body();
 
+                    auto encoding = content_encoding::identity;
+                    if (compression_min_size != 0) {
+                        encoding = select_encoding(con->get_request_header("Accept-Encoding"));
+                    }
+
                     try {
-                        api->call(body, [con](const std::string &data){
+                        api->call(body, [con, encoding, this](const std::string &data){
                             // this lambda can be called from any thread in application
                             //   for example, when task was delegated ( see msg_pack(msg_pack&&) )
-                            con->set_body(data);
-                            con->set_status(websocketpp::http::status_code::ok);
-                            con->send_http_response();
-                        });
+                            send_http_body(con, data, encoding);
+                        }, get_executor());
                     } catch (fc::exception &e) {
                         // this case happens if exception was thrown on parsing request
                         edump((e));
@@ -259,15 +465,41 @@ namespace graphene {
                         "Local websocket endpoint for webserver requests.")
                     ("rpc-endpoint", boost::program_options::value<string>(),
                         "Local http and websocket endpoint for webserver requests. Deprectaed in favor of webserver-http-endpoint and webserver-ws-endpoint")
-                    ("webserver-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(256),
-                        "Number of threads used to handle queries. Default: 256.");
+                    ("webserver-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(0),
+                        "Number of threads used to handle queries. Default: 0 - the number of CPU cores.")
+                    ("webserver-heavy-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(2),
+                        "Number of threads used to handle heavy queries (see rpc-heavy-methods). Default: 2.")
+                    ("webserver-compression-min-size", boost::program_options::value<uint32_t>()->default_value(1024),
+                        "Minimum size of http responses in bytes, which are compressed by gzip or deflate "
+                        "if clients accept them, 0 disables the compression.")
+                    ("webserver-metrics-path", boost::program_options::value<string>(),
+                        "Path on the http endpoint, which serves RPC and write queue statistics in the Prometheus text format. "
+                        "Example: /metrics");
             }
 
             void webserver_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 auto thread_pool_size = options.at("webserver-thread-pool-size").as<thread_pool_size_t>();
-                FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
-                ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
-                my.reset(new webserver_plugin_impl(thread_pool_size));
+                if (thread_pool_size == 0) {
+                    thread_pool_size = std::max<thread_pool_size_t>(std::thread::hardware_concurrency(), 1);
+                }
+                auto heavy_thread_pool_size = options.at("webserver-heavy-thread-pool-size").as<thread_pool_size_t>();
+                FC_ASSERT(heavy_thread_pool_size > 0, "webserver-heavy-thread-pool-size must be greater than 0");
+                ilog("configured with ${tps} thread pool size, ${htps} heavy thread pool size",
+                     ("tps", thread_pool_size)("htps", heavy_thread_pool_size));
+                my.reset(new webserver_plugin_impl(thread_pool_size, heavy_thread_pool_size));
+
+                my->compression_min_size = options.at("webserver-compression-min-size").as<uint32_t>();
+#ifndef WEBSERVER_COMPRESSION
+                if (my->compression_min_size != 0) {
+                    wlog("webserver is built without zlib, http responses aren't compressed");
+                    my->compression_min_size = 0;
+                }
+#endif
+
+                if (options.count("webserver-metrics-path")) {
+                    my->metrics_path = options.at("webserver-metrics-path").as<string>();
+                    ilog("configured to serve metrics at ${p}", ("p", *my->metrics_path));
+                }
 
                 if (options.count("webserver-http-endpoint")) {
                     auto http_endpoint = options.at("webserver-http-endpoint").as<string>();
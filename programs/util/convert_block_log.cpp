@@ -0,0 +1,92 @@
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <graphene/chain/block_log.hpp>
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+using graphene::chain::block_log;
+using graphene::chain::block_log_compression;
+
+int main(int argc, char **argv) {
+    try {
+        bpo::options_description options("convert_block_log <block_log> [options]\n\n"
+            "Converts the block log into another format. By default the block log and its index are replaced in place, "
+            "vizd should be stopped");
+        options.add_options()
+            ("help,h", "Print this help message and exit")
+            ("block-log", bpo::value<std::string>(), "Path to the block log")
+            ("compression", bpo::value<std::string>()->default_value("zstd"), "Compression: none, zstd or lz4")
+            ("chunk-blocks", bpo::value<uint32_t>()->default_value(256), "Number of blocks in a compressed chunk")
+            ("output", bpo::value<std::string>(), "Write the converted block log to this path instead of replacing");
+
+        bpo::positional_options_description positional;
+        positional.add("block-log", 1);
+
+        bpo::variables_map vm;
+        bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        bpo::notify(vm);
+
+        if (vm.count("help") || !vm.count("block-log")) {
+            std::cerr << options << "\n";
+            return 1;
+        }
+
+        const bfs::path input_path = vm["block-log"].as<std::string>();
+        const bool in_place = !vm.count("output");
+        const bfs::path output_path = in_place
+            ? bfs::path(input_path.string() + ".converting")
+            : bfs::path(vm["output"].as<std::string>());
+
+        const auto compression = fc::reflector<block_log_compression>::from_string(
+            vm["compression"].as<std::string>().c_str());
+        const auto chunk_blocks = vm["chunk-blocks"].as<uint32_t>();
+
+        FC_ASSERT(bfs::exists(input_path), "Block log ${p} doesn't exist", ("p", input_path.string()));
+        FC_ASSERT(!bfs::exists(output_path), "Output ${p} already exists", ("p", output_path.string()));
+
+        block_log input;
+        input.open(input_path);
+        FC_ASSERT(input.head(), "Block log is empty");
+
+        block_log output;
+        output.set_compression(compression, chunk_blocks, 0);
+        output.open(output_path);
+
+        const auto head_block_num = input.head()->block_num();
+        for (uint32_t block_num = 1; block_num <= head_block_num; ++block_num) {
+            auto block = input.read_block_by_num(block_num);
+            FC_ASSERT(block, "Block ${n} isn't found in block log", ("n", block_num));
+            output.append(*block);
+
+            if (block_num % 100000 == 0 || block_num == head_block_num) {
+                std::cerr << "   " << block_num << " of " << head_block_num << "\n";
+            }
+        }
+
+        output.close();
+        input.close();
+
+        const auto input_size = bfs::file_size(input_path);
+        const auto output_size = bfs::file_size(output_path);
+
+        if (in_place) {
+            bfs::rename(output_path, input_path);
+            bfs::rename(bfs::path(output_path.string() + ".index"), bfs::path(input_path.string() + ".index"));
+        }
+
+        std::cerr << "Converted " << head_block_num << " blocks, "
+            << input_size << " bytes -> " << output_size << " bytes\n";
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << "\n";
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -10,7 +10,7 @@ int main(int argc, char **argv, char **envp) {
         //db.open( temp_dir );
         log.open(temp_dir.path() / "log");
 
-        idump((log.head()));
+        idump((log.head_block_num()));
 
         graphene::protocol::signed_block b1;
         b1.witness = "alice";
@@ -19,7 +19,7 @@ int main(int argc, char **argv, char **envp) {
         log.append(b1);
         log.flush();
         idump((b1));
-        idump((log.head()));
+        idump((log.head_block_num()));
         idump((fc::raw::pack_size(b1)));
 
         graphene::protocol::signed_block b2;
@@ -29,7 +29,7 @@ int main(int argc, char **argv, char **envp) {
         log.append(b2);
         log.flush();
         idump((b2));
-        idump((log.head()));
+        idump((log.head_block_num()));
         idump((fc::raw::pack_size(b2)));
 
         auto r1 = log.read_block(0);
@@ -43,8 +43,12 @@ chown vizd:vizd $HOME/config.ini
 
 if [[ ! -d $HOME/blockchain ]]; then
     if [[ -e /var/cache/vizd/blocks.tbz2 ]]; then
-        # init with blockchain cached in image
-        ARGS+=" --replay-blockchain"
+        # init with blockchain cached in image, the state snapshot saves replaying of it
+        if [[ -e /var/cache/vizd/state_snapshot ]]; then
+            ARGS+=" --import-state-snapshot=/var/cache/vizd/state_snapshot"
+        else
+            ARGS+=" --replay-blockchain"
+        fi
         mkdir -p $HOME/blockchain/database
         cd $HOME/blockchain/database
         tar xvjpf /var/cache/vizd/blocks.tbz2